@@ -0,0 +1,28 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @brief Run a piece of work iterations times and return the nanoseconds one run took on average
+ *
+ * A tenth of the iterations run first without being timed, so the caches and the branch predictor look like they do while serving.
+ */
+template <class benchmark>
+inline double measure(size_t iterations, benchmark run) {
+  for (size_t i = 0; i < iterations / 10; i++) {
+    run();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < iterations; i++) {
+    run();
+  }
+
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "../../libkleinsHTTP.h"
+#include "../benchmark.h"
+
+#include <cstdio>
+#include <vector>
+
+// A connection that counts what is sent instead of writing it, so only building the response is timed
+class discardConnection : public kleins::connectionBase {
+public:
+  size_t written = 0;
+
+  bool getAlive() {
+    return true;
+  }
+
+  int getFd() {
+    return -1;
+  }
+
+  void tick() {
+  }
+
+  void close_socket() {
+  }
+
+protected:
+  void writeData(const char* /*data*/, int datalength) {
+    written += datalength;
+  }
+
+  void writeShared(std::shared_ptr<const char> /*data*/, size_t length) {
+    written += length;
+  }
+};
+
+int main(int argc, char** argv) {
+  size_t iterations = argc > 1 ? std::stoull(argv[1]) : 200000;
+
+  // Responses need the server for the keep-alive header, it doesn't listen anywhere
+  kleins::httpServer server(1);
+  discardConnection conn;
+  kleins::requestArena arena;
+
+  std::string request = "GET /api/items HTTP/1.1\r\n"
+                        "Host: api.example.com\r\n"
+                        "User-Agent: python-requests/2.31.0\r\n"
+                        "Accept: application/json\r\n"
+                        "Connection: keep-alive\r\n"
+                        "\r\n";
+
+  std::vector<std::pair<const char*, std::string>> bodies = {
+      {"13 B", "Hello, world!"},
+      {"1 KiB", std::string(1024, 'x')},
+      {"64 KiB", std::string(64 * 1024, 'x')},
+  };
+
+  printf("%-7s %16s %16s %16s %16s %16s\n", "body", "builder ns", "parse ns", "respond ns", "respond(code) ns", "serialized ns");
+
+  for (auto& body : bodies) {
+    // The builder on its own, writing the head an endpoint's response usually has
+    double builder = measure(iterations, [&]() {
+      {
+        kleins::responseBuilder response(arena.getResource(), 512 + body.second.length());
+        response.status(200);
+        response.header("Cache-Control: no-store");
+        response.date();
+        response.server();
+        response.contentLength(body.second.length());
+        response.contentType("application/json");
+        response.endHead();
+        response.append(body.second);
+        conn.written += response.length();
+      }
+      arena.reset();
+    });
+
+    // Every respond below parses the request first, like the server does, this is that part alone
+    double parse = measure(iterations, [&]() {
+      {
+        kleins::httpParser parser(request, &conn, &server, arena.getResource());
+        parser.parseHead();
+      }
+      arena.reset();
+    });
+
+    double respond = measure(iterations, [&]() {
+      {
+        kleins::httpParser parser(request, &conn, &server, arena.getResource());
+        parser.parseHead();
+        parser.respond("200", {"Cache-Control: no-store"}, body.second, "application/json");
+      }
+      arena.reset();
+    });
+
+    double respondCode = measure(iterations, [&]() {
+      {
+        kleins::httpParser parser(request, &conn, &server, arena.getResource());
+        parser.parseHead();
+        parser.respond(200, body.second, "application/json", {"Cache-Control: no-store"});
+      }
+      arena.reset();
+    });
+
+    kleins::responseBuilder serialized(std::pmr::new_delete_resource(), 512 + body.second.length());
+    serialized.contentLength(body.second.length());
+    serialized.contentType("application/json");
+    serialized.header("Cache-Control: no-store");
+    serialized.server();
+    serialized.endHead();
+    serialized.append(body.second);
+
+    double respondSerialized = measure(iterations, [&]() {
+      {
+        kleins::httpParser parser(request, &conn, &server, arena.getResource());
+        parser.parseHead();
+        parser.respondSerialized(200, std::string_view(serialized.data(), serialized.length()));
+      }
+      arena.reset();
+    });
+
+    printf("%-7s %16.1f %16.1f %16.1f %16.1f %16.1f\n", body.first, builder, parse, respond, respondCode, respondSerialized);
+  }
+
+  return conn.written == 0;
+}
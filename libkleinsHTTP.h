@@ -0,0 +1,3473 @@
+#define SINGLE_HEADER
+
+namespace kleins {
+    namespace metrics {
+        class metricBase;
+        class shardedCounter;
+        class counterMetric;
+        class histogramMetric;
+        class gaugeMetric;
+        class metricServer;
+    };
+    class packet;
+    class timerWheel;
+    class connectionBase;
+    class eventLoop;
+    class workerPool;
+    class responseBuilder;
+    class staticFile;
+    class fileCache;
+    class scanner;
+    class requestArena;
+    class requestReader;
+    class router;
+    class responseWriter;
+    class tcpConnection;
+    class uringConnection;
+    class httpParser;
+    class socketBase;
+    class uringSocket;
+    class sessionBase;
+    class sessionPoolBase;
+    class sessionStore;
+    class sessionSnapshot;
+}
+#ifndef PACKET_H
+#define PACKET_H
+
+#include <string>
+
+namespace kleins {
+struct packet {
+public:
+  std::string data;
+  int size;
+};
+} // namespace kleins
+
+#endif 
+#ifndef SOCKETBASE_H
+#define SOCKETBASE_H
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <future>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief Tuning of the listening sockets of a socketBase
+ */
+struct listenerOptions {
+  /**
+   * @brief The amount of SO_REUSEPORT listeners to open on the address, each with its own accept thread.
+   * Connections accepted by a shard are handled by the matching eventLoop thread. 0 uses one per core.
+   */
+  unsigned int shards = 1;
+
+  /**
+   * @brief The length of the queue of connections waiting to be accepted
+   */
+  int backlog = SOMAXCONN;
+
+  /**
+   * @brief Accept every pending connection per wakeup instead of one
+   */
+  bool batchAccept = true;
+
+  /**
+   * @brief Only wake up for a connection once it sent data, waiting at most this many seconds (TCP_DEFER_ACCEPT). 0 disables it.
+   */
+  int deferAcceptSeconds = 0;
+
+  /**
+   * @brief The amount of pending TCP Fast Open requests, which let clients send their request with the SYN. 0 disables it.
+   */
+  int fastOpenQueue = 0;
+};
+
+class socketBase {
+protected:
+  static void tickLoop(socketBase* socket, unsigned int shard);
+  std::vector<std::thread*> tickThreads;
+  std::atomic<bool> keepTicking{true};
+
+  listenerOptions options;
+
+  // The amount of listeners this socket is split into, each one gets its own accept thread
+  unsigned int shardCount = 1;
+
+  virtual bool tick(unsigned int shard) = 0;
+
+  /**
+   * @brief Wake up the tick threads waiting for connections, so they notice that they should stop
+   */
+  virtual void interruptTicks();
+
+  /**
+   * @brief Create a non blocking socket bound to address and listen on it as set up in options.
+   * SO_REUSEPORT is set so several shards can share the address.
+   *
+   * @return The file descriptor, or -1 on error
+   */
+  int openListenSocket(const struct sockaddr_in& address);
+
+  /**
+   * @brief Wait until listenfd has connections to accept
+   *
+   * @return false if waiting failed
+   */
+  bool waitForConnections(int listenfd);
+
+public:
+  socketBase(const listenerOptions& listenOptions = listenerOptions());
+  virtual ~socketBase();
+
+  void startTicks();
+
+  /**
+   * @brief Stop accepting connections and wait for the tick threads to finish.
+   * The destructors of derived sockets call this before closing anything tick uses.
+   */
+  void stopTicks();
+
+  std::function<void(connectionBase*)> newConnectionCallback;
+  virtual std::future<bool> init() = 0;
+};
+
+} // namespace kleins
+
+#endif
+ 
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace kleins {
+
+/**
+ * @brief A hierarchical timer wheel, which schedules and cancels timers in constant time however many there are.
+ *
+ * Time is counted in ticks, what a tick stands for is up to the owner. Each level has 64 slots, a slot of the first level covers one tick
+ * and a slot of every further level covers all of the level below it. Timers sit on the lowest level their deadline fits into
+ * and move down a level whenever the level below wraps around, so advancing only ever touches the timers that are due
+ * and the few that move down. Deadlines further out than the last level are parked in it and moved along until they are in reach.
+ *
+ * The timers are part of the objects they belong to, so scheduling them doesn't allocate. The wheel isn't locked,
+ * it's meant to be owned by one thread or used under the lock of its owner.
+ */
+class timerWheel {
+public:
+  static const unsigned int slotBits = 6;
+  static const unsigned int slotCount = 1 << slotBits;
+  static const unsigned int levelCount = 4;
+
+  /**
+   * @brief A timer, embedded into whatever it times out. It must not be destroyed while it's scheduled.
+   */
+  struct timer {
+    uint64_t deadline = 0;
+
+    timer* next = 0;
+    timer* previous = 0;
+
+    // The slot the timer is in, 0 while it isn't scheduled
+    timer** slot = 0;
+
+    bool isScheduled() const;
+  };
+
+private:
+  timer* slots[levelCount][slotCount] = {};
+
+  uint64_t currentTick;
+  size_t timerCount = 0;
+
+  void place(timer* entry);
+  void unlink(timer* entry);
+  void cascade(unsigned int level);
+
+public:
+  /**
+   * @param startTick The tick the wheel starts at, timers due by then fire on the next advance
+   */
+  timerWheel(uint64_t startTick = 0);
+
+  timerWheel(const timerWheel&) = delete;
+  timerWheel& operator=(const timerWheel&) = delete;
+
+  /**
+   * @brief Schedule a timer to fire once the wheel advanced to deadline. A timer that is already scheduled is moved.
+   */
+  void schedule(timer* entry, uint64_t deadline);
+
+  /**
+   * @brief Take a timer off the wheel, nothing happens if it isn't scheduled
+   */
+  void cancel(timer* entry);
+
+  /**
+   * @brief Move the wheel forward and fire every timer due by then
+   *
+   * @param tick The tick to advance to, ticks before the current one are ignored
+   * @param expired Called with every timer that fired. It's no longer scheduled then, so the callback may schedule it again or destroy it.
+   * @return The amount of timers that fired
+   */
+  size_t advance(uint64_t tick, const std::function<void(timer*)>& expired);
+
+  uint64_t getCurrentTick() const;
+
+  /**
+   * @brief The amount of scheduled timers
+   */
+  size_t size() const;
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef CONNECTIONBASE_H
+#define CONNECTIONBASE_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#ifndef SINGLE_HEADER
+#include "../packet/packet.h"
+#include "../timerWheel/timerWheel.h"
+#endif
+
+namespace kleins {
+class eventLoop;
+class connectionBase;
+
+/**
+ * @brief How long a connection may take for each part of an exchange, in milliseconds. 0 disables a timeout.
+ */
+struct connectionTimeouts {
+  /**
+   * @brief How long a connection may go without receiving or sending anything while it isn't in the middle of a request.
+   * It doesn't run while a callback on the worker pool is handling a request of the connection.
+   */
+  unsigned int idle = 30000;
+
+  /**
+   * @brief How long the request line and headers of a request may take to arrive, counted from their first byte
+   */
+  unsigned int header = 10000;
+
+  /**
+   * @brief How long the body of a request may take to arrive, counted from the end of its head. Streamed bodies are only bound by the idle timeout.
+   */
+  unsigned int body = 60000;
+
+  /**
+   * @brief How long the client may go without taking any of the pending output
+   */
+  unsigned int write = 30000;
+};
+
+/**
+ * @brief The timer of a connection on the timer wheel of the thread driving it
+ */
+struct connectionTimer : timerWheel::timer {
+  connectionBase* owner = 0;
+};
+
+class connectionBase {
+  friend class eventLoop;
+
+private:
+  connectionTimeouts timeouts;
+
+  // The timer wheel of the thread driving this connection, and the time of that thread in milliseconds, which it reads once per batch of events.
+  // Activity only stores that time, the timer is moved when it fires early or a read deadline comes before it.
+  connectionTimer timeoutTimer;
+  timerWheel* timeoutWheel = 0;
+  const uint64_t* loopTime = 0;
+
+  uint64_t lastActivity = 0;
+
+  // When the request being read has to be complete, 0 if there is no such deadline
+  uint64_t readDeadline = 0;
+
+  // The eventLoop driving this connection and its per thread state, set by eventLoop::addConnection.
+  eventLoop* loop = 0;
+  void* loopWorker = 0;
+
+  // The epoll events this connection is currently registered for, maintained by the eventLoop.
+  uint32_t watchedEvents = 0;
+
+  bool readingPaused = false;
+
+  // Requests handed off to other threads. The eventLoop keeps the connection alive until all of them came back.
+  unsigned int requestsInFlight = 0;
+  bool orphaned = false;
+
+  // Threads blocked in waitUntilDrained, with the amount of pending bytes each of them waits for
+  std::list<std::pair<size_t, std::promise<void>*>> drainWaiters;
+
+  void releaseDrainWaiters();
+
+protected:
+  // A piece of output that could not be written yet, either bytes, bytes shared with other owners or a range of a file
+  struct outputChunk {
+    std::string data;
+    std::shared_ptr<const char> shared;
+    int filefd = -1;
+    off_t offset = 0;
+    size_t length = 0;
+
+    // Keeps the file of a file chunk open until the chunk was written
+    std::shared_ptr<const void> fileOwner;
+  };
+
+  // Output that could not be written without blocking, flushed in order once the socket becomes writable again.
+  std::deque<outputChunk> pendingOutput;
+
+  // The bytes held in the data chunks of pendingOutput
+  size_t pendingBytes = 0;
+
+  bool closed = false;
+  bool closeRequested = false;
+
+  /**
+   * @brief Write as much of data as the socket takes without blocking
+   *
+   * @return The amount of bytes written, 0 if the socket would block, -1 on error
+   */
+  virtual ssize_t writeSome(const char* data, size_t length);
+
+  /**
+   * @brief Write as much of a file range as the socket takes without blocking. Reads the file through a buffer unless overridden.
+   *
+   * @return The amount of bytes written, 0 if the socket would block, -1 on error
+   */
+  virtual ssize_t sendFileSome(int filefd, off_t offset, size_t length);
+
+  /**
+   * @brief Write data to the peer. Never blocks, whatever can't be written right away is kept in pendingOutput.
+   * Only called from the thread driving the connection.
+   */
+  virtual void writeData(const char* data, int datalength);
+
+  /**
+   * @brief Like writeData, for a range of a file. fileOwner is held as long as the range is queued.
+   */
+  virtual void writeFile(int filefd, off_t offset, size_t length, std::shared_ptr<const void> fileOwner);
+
+  /**
+   * @brief Like writeData, but whatever can't be written right away is kept by holding on to data instead of copying it
+   */
+  virtual void writeShared(std::shared_ptr<const char> data, size_t length);
+
+public:
+  connectionBase();
+  virtual ~connectionBase();
+
+  virtual bool getAlive() = 0;
+
+  /**
+   * @brief The file descriptor the eventLoop should watch for this connection
+   */
+  virtual int getFd() = 0;
+
+  /**
+   * @brief Read everything that is currently available. Called by the eventLoop when the socket is readable.
+   */
+  virtual void tick() = 0;
+
+  /**
+   * @brief Write out pendingOutput. Called by the eventLoop when the socket is writable.
+   */
+  virtual void flush();
+
+  /**
+   * @brief Send data to the peer. Never blocks and may be called from any thread,
+   * calls from outside the eventLoop thread of the connection are forwarded to it.
+   */
+  void sendData(const char* data, int datalength);
+
+  /**
+   * @brief Send length bytes of an open file starting at offset, after everything sent before. Like sendData it may be called from any thread.
+   *
+   * @param filefd The file, it has to stay open until the data is sent
+   * @param fileOwner Whatever keeps the file open, e.g. a staticFile::descriptor. It's held until the data is sent.
+   */
+  void sendFile(int filefd, off_t offset, size_t length, std::shared_ptr<const void> fileOwner = std::shared_ptr<const void>());
+
+  /**
+   * @brief Send length bytes of memory that is shared with other owners, like a mapped file, without copying it.
+   * The memory is held until it was written. Like sendData it may be called from any thread.
+   */
+  void sendShared(std::shared_ptr<const char> data, size_t length);
+
+  virtual void close_socket() = 0;
+
+  /**
+   * @brief Close the socket as soon as all pending output has been written. May be called from any thread.
+   */
+  void closeAfterFlush();
+
+  /**
+   * @brief Block until no more than maxPendingBytes of sent data are waiting to be written, or the connection is closed.
+   * Returns right away on the thread driving the connection, which can't wait for itself.
+   */
+  void waitUntilDrained(size_t maxPendingBytes);
+
+  /**
+   * @brief Run task on the thread that drives this connection, right away if this is already that thread.
+   * Tasks of one connection run in the order they were posted.
+   */
+  void runOnLoop(std::function<void()> task);
+
+  /**
+   * @brief Stop or resume reading from the socket. Only call these from the thread driving the connection.
+   */
+  void pauseReading();
+  void resumeReading();
+  bool getReadingPaused();
+
+  /**
+   * @brief Mark a request as handed off to another thread. The connection won't be deleted until requestDone() was called for it.
+   * Only call these from the thread driving the connection.
+   */
+  void requestStarted();
+  void requestDone();
+
+  virtual bool hasPendingOutput();
+
+  /**
+   * @brief Whether the connection still has to finish a handshake before it carries requests. It has to be done within the header timeout.
+   */
+  virtual bool handshakePending();
+
+  /**
+   * @brief Whether this connection should be handed to the eventLoop. Backends that drive their own I/O return false.
+   */
+  virtual bool usesEventLoop();
+
+  /**
+   * @brief Set the idle timeout
+   */
+  void setTimeout(unsigned int timeoutInMS = 30000);
+
+  void setTimeouts(const connectionTimeouts& connTimeouts);
+
+  /**
+   * @brief Put the connection on the timer wheel of the thread driving it. Only call this and the following from that thread.
+   *
+   * @param wheel The timer wheel, counting milliseconds
+   * @param time The current time of the wheel's thread, it has to stay valid until stopTimeouts
+   */
+  void startTimeouts(timerWheel* wheel, const uint64_t* time);
+
+  /**
+   * @brief Take the connection off its timer wheel
+   */
+  void stopTimeouts();
+
+  /**
+   * @brief Called when the timer of the connection fired. Puts the timer back if the connection has time left.
+   *
+   * @return Whether the connection timed out and has to be closed
+   */
+  bool timeoutFired();
+
+  /**
+   * @brief Mark the connection as active. Doesn't read the clock, it takes the time its thread read for the current batch of events.
+   */
+  void resetTimeoutTimer();
+
+  /**
+   * @brief Require the request being read to be complete within timeoutInMS. Replaces the previous read deadline.
+   */
+  void setReadDeadline(unsigned int timeoutInMS);
+  void clearReadDeadline();
+
+  /**
+   * @brief When the connection times out, in the time of its timer wheel. 0 if it never does.
+   */
+  uint64_t getDeadline();
+  bool getTimeout();
+
+  const connectionTimeouts& getTimeouts();
+
+  /**
+   * @brief The listener shard that accepted this connection, the eventLoop keeps it on the matching thread. -1 if the listener isn't sharded.
+   */
+  int shard = -1;
+
+  std::function<void(std::unique_ptr<packet>)> onRecieveCallback;
+};
+} // namespace kleins
+
+#endif
+ 
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#include "../timerWheel/timerWheel.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief An epoll reactor that drives all connections of a server from a fixed set of threads.
+ *
+ * Every thread owns its own epoll instance and the connections assigned to it, so a connection is only ever ticked from one thread.
+ * A thread only wakes up when one of its sockets becomes readable or writable, work was posted to it, or once per second to check its timeouts.
+ * The timeouts of all connections of a thread are on one timer wheel, which the thread advances after every batch of events,
+ * so only connections that are due are ever looked at and the clock is read once per batch instead of on every read or write.
+ */
+class eventLoop {
+private:
+  struct worker {
+    int epollfd;
+    std::thread* thread = 0;
+    std::thread::id threadId;
+
+    // Guards connections and arriving, new connections get added from the accepting thread
+    std::mutex connectionsMutex;
+    std::unordered_set<connectionBase*> connections;
+
+    // Connections added since the thread last looked, their timeouts are started on the thread itself
+    std::vector<connectionBase*> arriving;
+
+    // Milliseconds since the loop started, read once per batch of events. Ticks of the timer wheel are milliseconds as well.
+    uint64_t now = 0;
+    timerWheel timeouts;
+
+    // Work posted from other threads, wakefd is signaled whenever something gets added
+    int wakefd;
+    std::mutex tasksMutex;
+    std::vector<std::pair<connectionBase*, std::function<void()>>> tasks;
+
+    // Set under tasksMutex once the thread was stopped, posted work runs on the posting thread from then on
+    bool stopped = false;
+  };
+
+  std::vector<std::unique_ptr<worker>> workers;
+  std::atomic<unsigned int> nextWorker{0};
+  std::atomic<bool> keepRunning{true};
+
+  std::chrono::time_point<std::chrono::steady_clock> startTime;
+
+  // Serializes the work posted after stop, which may post again while it runs
+  std::recursive_mutex stoppedTasksMutex;
+
+  static void workerLoop(eventLoop* loop, worker* w);
+
+  void handleEvents(worker* w, connectionBase* conn, uint32_t events);
+  void updateWatchedEvents(worker* w, connectionBase* conn);
+  void removeConnection(worker* w, connectionBase* conn);
+  void startTimeouts(worker* w);
+  void closeTimedOut(worker* w);
+  void runTasks(worker* w);
+  void runStoppedTask(connectionBase* conn, std::function<void()>& task);
+
+public:
+  /**
+   * @brief Start the event loop
+   *
+   * @param threadCount The amount of threads to serve connections from. 0 uses one per core.
+   */
+  eventLoop(unsigned int threadCount = 0);
+
+  /**
+   * @brief Stop all threads and close every connection that is still open
+   */
+  ~eventLoop();
+
+  /**
+   * @brief Stop all threads, leaving the connections to the destructor. Lets an owner wait for work that still refers to the connections
+   * before they are deleted.
+   *
+   * The connections are closed, which releases every thread in waitUntilDrained. Work that was posted and work posted from now on
+   * runs on the thread that stops the loop or posts it, one task at a time.
+   */
+  void stop();
+
+  /**
+   * @brief Hand a connection over to the event loop
+   *
+   * @param conn The connection. The event loop takes ownership and deletes it once it is closed.
+   */
+  void addConnection(connectionBase* conn);
+
+  /**
+   * @brief Queue task to run on the thread that drives conn and wake that thread up
+   */
+  void post(connectionBase* conn, std::function<void()> task);
+
+  /**
+   * @brief Whether the calling thread is the one driving conn
+   */
+  bool onLoopThread(connectionBase* conn);
+};
+
+} // namespace kleins
+
+#endif
+ 
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kleins {
+
+/**
+ * @brief A fixed set of threads that run submitted tasks.
+ *
+ * Every thread has its own queue and takes work from its front. Threads that run dry steal from the back of the others,
+ * so a few slow tasks don't hold up the ones queued behind them while other threads idle.
+ */
+class workerPool {
+private:
+  struct taskQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<taskQueue>> queues;
+  std::vector<std::thread*> threads;
+
+  std::atomic<unsigned int> nextQueue{0};
+  std::atomic<size_t> queuedTasks{0};
+  std::atomic<bool> keepRunning{true};
+
+  // Idle threads sleep here until something gets submitted
+  std::mutex idleMutex;
+  std::condition_variable idleCondition;
+
+  static void workerLoop(workerPool* pool, unsigned int index);
+  bool takeTask(unsigned int index, std::function<void()>& task);
+
+public:
+  /**
+   * @brief Start the pool
+   *
+   * @param threadCount The amount of threads. 0 uses one per core.
+   */
+  workerPool(unsigned int threadCount = 0);
+
+  /**
+   * @brief Finish the running tasks and stop all threads. Tasks that haven't started yet are dropped.
+   */
+  ~workerPool();
+
+  /**
+   * @brief Queue a task to be run on one of the pool threads
+   */
+  void submit(std::function<void()> task);
+};
+
+} // namespace kleins
+
+#endif
+ 
+#ifndef RESPONSEBUILDER_H
+#define RESPONSEBUILDER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace kleins {
+
+/**
+ * @brief Writes the bytes of a response into one buffer.
+ *
+ * Status lines of known status codes, the Server header and the other fixed lines are stored preformatted and only copied.
+ * The Date header is formatted at most once per second on every thread. Numbers are written without going through streams,
+ * so building a response doesn't allocate as long as the buffer comes from memory that is already there, like a requestArena.
+ */
+class responseBuilder {
+private:
+  std::pmr::memory_resource* memory;
+
+  char* buffer = 0;
+  size_t used = 0;
+  size_t capacity = 0;
+
+  void reserve(size_t size);
+
+public:
+  /**
+   * @param memory Where the buffer is allocated from
+   * @param expectedSize The size to reserve up front, so the buffer doesn't have to grow
+   */
+  responseBuilder(std::pmr::memory_resource* bufferMemory = std::pmr::get_default_resource(), size_t expectedSize = 512);
+  ~responseBuilder();
+
+  responseBuilder(const responseBuilder&) = delete;
+  responseBuilder& operator=(const responseBuilder&) = delete;
+
+  /**
+   * @brief Write the status line. A status that is just a known code gets the matching reason phrase, anything else is written as it is.
+   */
+  void status(std::string_view status);
+  void status(unsigned int code);
+
+  /**
+   * @brief Add a complete header line, without its line ending
+   */
+  void header(std::string_view line);
+  void header(std::string_view name, std::string_view value);
+
+  void contentLength(size_t length);
+
+  /**
+   * @brief Add the Content-Type header for a mime type, with the utf-8 charset
+   */
+  void contentType(std::string_view mimeType);
+
+  void date();
+  void server();
+
+  /**
+   * @brief End the head with an empty line
+   */
+  void endHead();
+
+  /**
+   * @brief Add raw bytes, e.g. the body
+   */
+  void append(const char* data, size_t length);
+  void append(std::string_view data);
+
+  const char* data() const;
+  size_t length() const;
+
+  void clear();
+
+  /**
+   * @brief The preformatted status line of a code including its line ending. Empty for codes without one.
+   */
+  static std::string_view statusLine(unsigned int code);
+
+  /**
+   * @brief The Date header line for the current second including its line ending, formatted once per second and thread
+   */
+  static std::string_view dateLine();
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef STATICFILE_H
+#define STATICFILE_H
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <openssl/evp.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef SINGLE_HEADER
+#include "../responseBuilder/responseBuilder.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief A file served by httpServer::serve.
+ *
+ * The file is only open while responses send it, so serving many files doesn't use up the descriptors connections need.
+ * Responses hand the descriptor to the connection so the body goes from the page cache to the socket without being copied through userspace.
+ * The validators for conditional requests (ETag and Last-Modified) are computed once when the file is added.
+ * Small files are also read into a response serialized up front, which plain requests for them get with one copy.
+ */
+class staticFile {
+public:
+  struct byteRange {
+    off_t offset;
+    size_t length;
+  };
+
+  // Requests asking for more ranges than this get the whole file instead
+  static const size_t maxRanges = 16;
+
+  // Files up to this size are kept in memory as part of their serialized response
+  static const size_t maxSerializedBodySize = 16 * 1024;
+
+  /**
+   * @brief An open descriptor of the file, closed once the last response holding it was sent
+   */
+  struct descriptor {
+    int fd;
+
+    descriptor(int openFd);
+    ~descriptor();
+
+    descriptor(const descriptor&) = delete;
+    descriptor& operator=(const descriptor&) = delete;
+  };
+
+private:
+  bool loaded = false;
+  size_t size = 0;
+
+  std::string path;
+  std::string mimeType;
+
+  // A hash of the content, quoted as it's sent
+  std::string etag;
+  time_t modified = 0;
+  std::string lastModified;
+
+  std::list<std::string> responseHeaders;
+
+  // Everything of a 200 response after the status line and the headers depending on the request: the fixed headers, the empty line and the body
+  std::string serializedResponse;
+
+  // Shared by the responses sending the file at the same time
+  std::mutex descriptorMutex;
+  std::weak_ptr<const descriptor> sharedDescriptor;
+
+  bool hashContent(int filefd);
+  bool serializeResponse(int filefd);
+  bool etagListed(const std::string& ifNoneMatch);
+  bool parseRange(const std::string& range, std::vector<byteRange>& ranges);
+
+public:
+  /**
+   * @brief Read a file to be served. It's closed again afterwards, see openDescriptor.
+   *
+   * @param filepath The local path of the file
+   * @param type The mime type the file is served with
+   * @param cacheControl The value of the Cache-Control header sent with the file, none is sent if it's empty
+   */
+  staticFile(const std::string& filepath, const std::string& type, const std::string& cacheControl = "");
+  ~staticFile();
+
+  /**
+   * @brief Whether the file could be read when it was added
+   */
+  bool isLoaded();
+
+  /**
+   * @brief Open the file for a response, or share the descriptor of the responses sending it right now. May be called from any thread.
+   *
+   * @return 0 if the file can't be opened, or it changed since it was added and its size and validators don't match anymore
+   */
+  std::shared_ptr<const descriptor> openDescriptor();
+
+  size_t getSize();
+  const std::string& getPath();
+  const std::string& getMimeType();
+  const std::string& getETag();
+
+  /**
+   * @brief The ETag, Last-Modified and Cache-Control headers to send along with the file
+   */
+  const std::list<std::string>& getHeaders();
+
+  /**
+   * @brief The 200 response for the file without its status line and the headers depending on the request, see httpParser::respondSerialized.
+   * Empty if the file is too big to be kept in memory.
+   */
+  std::string_view getSerializedResponse();
+
+  /**
+   * @brief Check the If-None-Match and If-Modified-Since headers of a request against the file, empty values stand for missing headers
+   *
+   * @return true if the client already has the current version and a 304 should be sent instead
+   */
+  bool isNotModified(std::string_view ifNoneMatch, std::string_view ifModifiedSince);
+
+  /**
+   * @brief Work out which parts of the file a request asks for with its Range and If-Range headers, empty values stand for missing headers
+   *
+   * @param ranges Filled with the satisfiable ranges, clamped to the file. Empty if none of the requested ranges can be satisfied.
+   * @return false if the whole file should be sent, because there is no usable Range header or If-Range doesn't match
+   */
+  bool requestedRanges(std::string_view range, std::string_view ifRange, std::vector<byteRange>& ranges);
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef FILECACHE_H
+#define FILECACHE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sys/mman.h>
+#include <unordered_map>
+
+#ifndef SINGLE_HEADER
+#include "../counterMetric/counterMetric.h"
+#include "../gaugeMetric/gaugeMetric.h"
+#include "../staticFile/staticFile.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief Keeps the contents of frequently served static files mapped into memory.
+ *
+ * Files are mapped the first time they are requested and stay resident while they fit into the memory budget,
+ * the least recently used ones are unmapped to make room for new ones. Files bigger than the per file limit are never mapped,
+ * those are better off being sent straight from the file.
+ */
+class fileCache {
+private:
+  struct entry {
+    staticFile* file;
+    std::shared_ptr<const char> mapping;
+  };
+
+  std::mutex mutex;
+
+  // Most recently used first
+  std::list<entry> recentlyUsed;
+  std::unordered_map<staticFile*, std::list<entry>::iterator> entries;
+
+  size_t budget;
+  size_t maxFileSize;
+  size_t residentBytes = 0;
+
+  void evictUntil(size_t targetBytes);
+
+public:
+  /**
+   * @param budgetBytes The amount of bytes that may be mapped at once. 0 disables the cache.
+   * @param maxFileSizeBytes Files bigger than this are never cached
+   */
+  fileCache(size_t budgetBytes, size_t maxFileSizeBytes);
+  ~fileCache();
+
+  /**
+   * @brief Change the limits, files that don't fit anymore are unmapped right away
+   */
+  void setLimits(size_t budgetBytes, size_t maxFileSizeBytes);
+
+  /**
+   * @brief Get the mapped contents of a file, mapping it if it isn't cached yet
+   *
+   * @return The contents of the file, they stay mapped as long as the pointer is held even if the file gets evicted meanwhile.
+   * Empty if the file can't be cached.
+   */
+  std::shared_ptr<const char> get(staticFile* file);
+
+  metrics::counterMetric* metric_hits;
+  metrics::counterMetric* metric_misses;
+  metrics::gaugeMetric* metric_residentBytes;
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <cstddef>
+#include <cstring>
+
+namespace kleins {
+
+/**
+ * @brief Delimiter searches used to take requests apart.
+ *
+ * They look at 32 (AVX2) or 16 (SSE4.2) bytes per step, the widest variant the cpu supports is picked when the library is loaded.
+ * A plain byte loop is the fallback for other cpus. All of them return 0 if nothing was found.
+ */
+class scanner {
+public:
+  typedef enum scanLevel {
+    SCAN_SCALAR,
+    SCAN_SSE42,
+    SCAN_AVX2,
+  } scanLevel;
+
+private:
+  typedef const char* (*headEndFunction)(const char* begin, const char* end);
+  typedef const char* (*eitherFunction)(const char* begin, const char* end, char first, char second);
+
+  static headEndFunction headEndImplementation;
+  static eitherFunction eitherImplementation;
+  static scanLevel level;
+
+public:
+  /**
+   * @brief The best level the cpu supports
+   */
+  static scanLevel detectLevel();
+
+  /**
+   * @brief Switch to another implementation, e.g. to compare them. Levels the cpu doesn't support fall back to the next lower one.
+   * Not thread safe, call it before serving.
+   */
+  static void setLevel(scanLevel newLevel);
+  static scanLevel getLevel();
+
+  /**
+   * @brief Find the empty line ending a request head
+   *
+   * @return The "\r\n\r\n" ending the head
+   */
+  static const char* findHeadEnd(const char* begin, const char* end);
+
+  /**
+   * @brief Find the first occurence of either of two characters
+   */
+  static const char* findEither(const char* begin, const char* end, char first, char second);
+
+  /**
+   * @brief Find the "\r\n" ending a line
+   */
+  static const char* findLineEnd(const char* begin, const char* end);
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef REQUESTARENA_H
+#define REQUESTARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+
+namespace kleins {
+
+/**
+ * @brief Memory for the request a connection is currently handling.
+ *
+ * Allocations are bumped off a buffer that is part of the arena, only requests that need more than that reach the heap.
+ * Nothing is freed on its own, reset() drops everything at once after the request was answered.
+ * An arena belongs to one connection, which only handles one request at a time, so it isn't locked.
+ */
+class requestArena {
+public:
+  static const size_t inlineSize = 8 * 1024;
+
+private:
+  alignas(std::max_align_t) char buffer[inlineSize];
+  std::pmr::monotonic_buffer_resource resource;
+
+public:
+  requestArena();
+  ~requestArena();
+
+  requestArena(const requestArena&) = delete;
+  requestArena& operator=(const requestArena&) = delete;
+
+  /**
+   * @brief The arena as a memory resource for pmr containers
+   */
+  std::pmr::memory_resource* getResource();
+
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /**
+   * @brief Copy data into the arena
+   */
+  std::string_view copy(std::string_view data);
+
+  /**
+   * @brief Free everything allocated since the last reset. Objects placed in the arena have to be destroyed before.
+   */
+  void reset();
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef REQUESTREADER_H
+#define REQUESTREADER_H
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <strings.h>
+
+#ifndef SINGLE_HEADER
+#include "../packet/packet.h"
+#include "../requestArena/requestArena.h"
+#include "../scanner/scanner.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief Size limits for incoming requests
+ */
+struct requestLimits {
+  /**
+   * @brief The maximum size of the request line and headers together. Bigger requests are answered with a 431.
+   */
+  size_t maxHeaderSize = 64 * 1024;
+
+  /**
+   * @brief The maximum size of a request body, after removing the chunked encoding. Bigger requests are answered with a 413.
+   */
+  size_t maxBodySize = 16 * 1024 * 1024;
+};
+
+/**
+ * @brief Reassembles HTTP requests from the bytes received on a connection.
+ *
+ * The reader keeps its state between reads, so requests may arrive in any amount of pieces and several of them in one piece.
+ * Bodies are collected according to Content-Length or Transfer-Encoding: chunked, chunked bodies are decoded on the way.
+ * Input is only held until it has been moved into the request it belongs to.
+ */
+class requestReader {
+public:
+  typedef enum readState {
+    READ_HEAD,
+    READ_BODY,
+    READ_CHUNK_SIZE,
+    READ_CHUNK_DATA,
+    READ_CHUNK_END,
+    READ_TRAILERS,
+    READ_COMPLETE,
+    READ_MALFORMED,
+    READ_HEAD_TOO_LARGE,
+    READ_BODY_TOO_LARGE,
+  } readState;
+
+private:
+  requestLimits limits;
+
+  std::string input;
+  readState state = READ_HEAD;
+
+  // The bytes at the start of input that were already read. They are only erased once they make up more than half of it,
+  // so each received byte is moved a bounded number of times instead of once for every line or piece taken off the front.
+  size_t consumed = 0;
+
+  // How far the unread input was already searched for the end of the head
+  size_t scanned = 0;
+
+  std::string head;
+  std::string body;
+
+  // Bodies up to this size leave their buffer to the next request
+  static const size_t maxRetainedBodySize = 64 * 1024;
+
+  size_t remaining = 0;
+  bool continueRequested = false;
+
+  bool headReady = false;
+  bool streaming = false;
+
+  readState parseHead();
+  bool takeLine(std::string& line);
+  size_t unread();
+  void consume(size_t length);
+
+public:
+  requestReader(const requestLimits& readerLimits = requestLimits());
+
+  /**
+   * @brief Add received bytes
+   */
+  void feed(const char* data, size_t length);
+
+  /**
+   * @brief Parse as far as the received bytes allow
+   *
+   * @return READ_COMPLETE once a whole request was read, one of the error states if the request can't be read, otherwise the state it stopped in
+   */
+  readState advance();
+
+  /**
+   * @brief Hand out the request that was just completed and start reading the next one
+   *
+   * @return The head of the request followed by its body, with any chunked encoding removed
+   */
+  std::unique_ptr<packet> takeRequest();
+
+  /**
+   * @brief Like takeRequest, but copies the request into an arena instead of allocating a packet for it
+   */
+  std::string_view takeRequest(requestArena& arena);
+
+  /**
+   * @brief Whether the head of a new request was read since the last call. advance() returns right after reading a head,
+   * before the body limit is checked, so the caller can switch the request to streaming first.
+   */
+  bool takeHeadReady();
+
+  /**
+   * @brief The request line and headers of the current request
+   */
+  const std::string& getHead();
+
+  /**
+   * @brief Stop collecting the body of the current request, it is handed out piece by piece through takeBody instead and maxBodySize doesn't apply to it
+   */
+  void streamBody();
+
+  /**
+   * @brief Move the body read so far out of the reader. Meant for streamed requests.
+   */
+  void takeBody(std::string& chunk);
+
+  /**
+   * @brief Drop what was read of the current request and start reading the next one
+   */
+  void reset();
+
+  /**
+   * @brief Whether the current request asked for a 100 Continue before sending its body. Only true once per request.
+   */
+  bool takeContinueRequest();
+
+  /**
+   * @brief Whether part of a request was received, but not all of it yet
+   */
+  bool hasPartialRequest();
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kleins {
+
+class httpParser;
+
+typedef enum httpMethod { GET, HEAD, POST, PUT, DELETE, CONNECT, OPTIONS, TRACE, PATCH } httpMethod;
+
+/**
+ * @brief Maps the method and path of a request to its endpoint, using a compressed radix tree.
+ *
+ * Patterns are matched segment by segment. A segment starting with ':' matches any single segment and a trailing segment starting with '*'
+ * matches the rest of the path, both make the matched text available under the name following the ':' or '*'.
+ * Static segments take precedence over parameters, and parameters over wildcards.
+ *
+ * Lookups don't allocate or lock. The tree is rebuilt once on the first lookup after routes were added and then shared by all threads,
+ * replaced trees are kept until the router is destroyed because lookups may still be walking them.
+ */
+class router {
+public:
+  static const size_t methodCount = PATCH + 1;
+
+  // The names of the methods by httpMethod, shared with routeTable so both match the same methods
+  static constexpr const char* methodNames[methodCount] = {"GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"};
+  static const size_t maxParameters = 8;
+
+  /**
+   * @brief An endpoint as it was added
+   */
+  struct route {
+    httpMethod method;
+    std::string pattern;
+    std::function<void(httpParser*)> handler;
+
+    // Whether the endpoint receives the body as it arrives, see httpServer::onStream
+    bool streamed = false;
+  };
+
+  /**
+   * @brief The result of a lookup. The parameters point into the looked up path and the pattern of the route.
+   */
+  struct routeMatch {
+    const route* matched = 0;
+
+    size_t parameterCount = 0;
+    std::string_view parameterNames[maxParameters];
+    std::string_view parameterValues[maxParameters];
+  };
+
+private:
+  struct node {
+    // The static text leading to this node from its parent
+    std::string prefix;
+
+    // The first characters of the static children, in the same order as children
+    std::string indices;
+    std::vector<std::unique_ptr<node>> children;
+
+    std::unique_ptr<node> parameterChild;
+    std::string parameterName;
+
+    std::unique_ptr<node> wildcardChild;
+    std::string wildcardName;
+
+    const route* routes[methodCount] = {};
+  };
+
+  // Every route ever added, the trees point into it. A list keeps them in place while more are added.
+  std::list<route> routes;
+
+  std::list<std::unique_ptr<node>> trees;
+  std::atomic<node*> root;
+  std::atomic<bool> outdated;
+
+  std::mutex buildMutex;
+
+  static std::unique_ptr<node> copyTree(const node* tree);
+
+  void rebuild();
+  bool insert(node* tree, const route* newRoute, bool patterns);
+  bool match(const node* current, std::string_view path, httpMethod method, routeMatch& result) const;
+
+public:
+  router();
+  ~router();
+
+  /**
+   * @brief Add an endpoint. Routes that were added before for the same method and pattern take precedence. May be called while serving.
+   *
+   * @param pattern The path to match, e.g. "/users/:id", a last segment like "*file" matches the rest of the path
+   * @param patterns Whether ':' and '*' segments are parameters, otherwise the pattern is matched literally
+   * @return false if the pattern is invalid
+   */
+  bool add(httpMethod method, const std::string& pattern, const std::function<void(httpParser*)> handler, bool streamed = false, bool patterns = true);
+
+  /**
+   * @brief Look up the endpoint for a request
+   *
+   * @return The matched route, 0 if there is none for this method and path
+   */
+  const route* find(std::string_view method, std::string_view path, routeMatch& result);
+
+  /**
+   * @brief Convert the name of a method as sent in a request
+   *
+   * @return false for unknown methods
+   */
+  static bool parseMethod(std::string_view name, httpMethod& method);
+
+  /**
+   * @brief The name of a method as sent in a request
+   */
+  static const char* methodName(httpMethod method);
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef ROUTETABLE_H
+#define ROUTETABLE_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#ifndef SINGLE_HEADER
+#include "../router/router.h"
+#endif
+
+namespace kleins {
+
+class httpParser;
+
+/**
+ * @brief An endpoint of a routeTable. The handler is any callable taking an httpParser*, it is stored and called by its own type.
+ */
+template <class handler>
+struct staticRoute {
+  httpMethod method;
+  std::string_view path;
+  handler callback;
+
+  constexpr staticRoute(httpMethod routeMethod, std::string_view routePath, handler routeCallback)
+      : method(routeMethod), path(routePath), callback(routeCallback) {
+  }
+};
+
+/**
+ * @brief Calls a function given as template parameter, so routes to plain functions are direct calls as well
+ *
+ * \code{.cpp}
+ * kleins::staticRoute(kleins::GET, "/hello", kleins::routeHandler<hello>())
+ * \endcode
+ */
+template <auto function>
+struct routeHandler {
+  constexpr void operator()(httpParser* parser) const {
+    function(parser);
+  }
+};
+
+/**
+ * @brief A fixed set of endpoints whose lookup table is built by the compiler.
+ *
+ * The method and path of every route are hashed into an open addressed table when the routeTable is constructed, in a constant expression
+ * if it's declared constexpr. A request is then dispatched with one hash of its method and path and a call of the handler by its own type,
+ * which the compiler can inline. Paths are matched exactly, routes with parameters belong in httpServer::on.
+ * When a method and path are listed more than once the first route is used.
+ *
+ * \code{.cpp}
+ * constexpr auto routes = kleins::makeRouteTable(
+ *     kleins::staticRoute(kleins::GET, "/", [](kleins::httpParser* parser) { parser->respond("200", {}, "Hello!"); }),
+ *     kleins::staticRoute(kleins::GET, "/hi", kleins::routeHandler<sayHi>()));
+ *
+ * server.on(routes);
+ * \endcode
+ */
+template <class... handlers>
+class routeTable {
+public:
+  static constexpr size_t routeCount = sizeof...(handlers);
+
+private:
+  // At most half of the slots are used, which keeps probe sequences short
+  static constexpr size_t slotCount() {
+    size_t count = 1;
+    while (count < routeCount * 2) {
+      count *= 2;
+    }
+    return count;
+  }
+
+  std::tuple<handlers...> callbacks;
+  std::array<std::string_view, routeCount> methods;
+  std::array<std::string_view, routeCount> paths;
+  std::array<uint64_t, routeCount> hashes;
+
+  // The index of the route stored in each slot plus one, 0 for empty slots
+  std::array<size_t, slotCount()> slots;
+
+  template <size_t... indices>
+  void call(size_t index, httpParser* parser, std::index_sequence<indices...>) const {
+    ((index == indices ? (std::get<indices>(callbacks)(parser), true) : false) || ...);
+  }
+
+public:
+  /**
+   * @brief The FNV-1a hash routes are stored under
+   */
+  static constexpr uint64_t hash(std::string_view method, std::string_view path) {
+    uint64_t value = 14695981039346656037ull;
+
+    for (char c : method) {
+      value = (value ^ (unsigned char)c) * 1099511628211ull;
+    }
+
+    value = (value ^ ' ') * 1099511628211ull;
+
+    for (char c : path) {
+      value = (value ^ (unsigned char)c) * 1099511628211ull;
+    }
+
+    return value;
+  }
+
+  constexpr routeTable(const staticRoute<handlers>&... routes)
+      : callbacks(routes.callback...), methods{router::methodNames[routes.method]...}, paths{routes.path...}, hashes{}, slots{} {
+    for (size_t i = 0; i < routeCount; i++) {
+      hashes[i] = hash(methods[i], paths[i]);
+
+      size_t slot = hashes[i] & (slotCount() - 1);
+
+      while (slots[slot] != 0) {
+        size_t stored = slots[slot] - 1;
+
+        if (hashes[stored] == hashes[i] && methods[stored] == methods[i] && paths[stored] == paths[i]) {
+          break;
+        }
+
+        slot = (slot + 1) & (slotCount() - 1);
+      }
+
+      if (slots[slot] == 0) {
+        slots[slot] = i + 1;
+      }
+    }
+  }
+
+  /**
+   * @brief Call the handler for a request
+   *
+   * @return false if the table has no route for the method and path
+   */
+  bool dispatch(std::string_view method, std::string_view path, httpParser* parser) const {
+    uint64_t requestHash = hash(method, path);
+
+    for (size_t slot = requestHash & (slotCount() - 1); slots[slot] != 0; slot = (slot + 1) & (slotCount() - 1)) {
+      size_t index = slots[slot] - 1;
+
+      if (hashes[index] == requestHash && methods[index] == method && paths[index] == path) {
+        call(index, parser, std::index_sequence_for<handlers...>());
+        return true;
+      }
+    }
+
+    return false;
+  }
+};
+
+/**
+ * @brief Build a routeTable, the handler types are deduced from the routes
+ */
+template <class... handlers>
+constexpr routeTable<handlers...> makeRouteTable(const staticRoute<handlers>&... routes) {
+  return routeTable<handlers...>(routes...);
+}
+}; // namespace kleins
+
+#endif
+ 
+#ifndef SESSIONBASE_H
+#define SESSIONBASE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace kleins {
+class sessionPoolBase;
+class sessionStore;
+
+/**
+ * @brief a base class for storing session data.
+ * 
+ * To use this, start the httpServer with the autosession flag and inherit this class to modify it how you like.
+ */
+class sessionBase {
+public:
+  /**
+     * @brief Default constructor.
+     * 
+     * @param timeout When the session should expire in minutes from now
+     * 
+     * Sets the time when this session expires.
+     */
+  sessionBase(unsigned int timeout = 480);
+
+  /**
+     * @brief Destroy the session Base object
+     * 
+     * Virtual, as sessions are deleted through this base class once they expired
+     */
+  virtual ~sessionBase();
+
+  /**
+     * @brief Write the data of the session into a session snapshot, see httpServer::setSessionSnapshot
+     * 
+     * @param data Where to append the data
+     * 
+     * Writes nothing unless overridden, sessions are then restored with their key and expireTime only.
+     * It is called while the session may be in use by a request, so guard data that endpoints change.
+     */
+  virtual void serialize(std::string& data) const;
+
+  /**
+     * @brief Restore the data written by serialize, in a new session of the same class
+     * 
+     * @return false if the data can't be used, a new session is started instead
+     */
+  virtual bool deserialize(std::string_view data);
+
+  static const size_t keyLength = 32;
+
+  /**
+     * @brief The session key this session uses.
+     * 
+     * Points into the session itself, empty until the session is stored.
+     */
+  std::string_view sessionKey;
+
+  /**
+     * @brief Where sessionKey points, the key is kept in the session so storing it doesn't allocate
+     * 
+     */
+  char keyStorage[keyLength];
+
+  /**
+     * @brief The pool the session was allocated from, 0 if it was created with new
+     * 
+     */
+  sessionPoolBase* pool = 0;
+
+  /**
+     * @brief The time at which this session expires
+     * 
+     */
+  std::chrono::time_point<std::chrono::system_clock> getExpireTime() const;
+
+  /**
+     * @brief Move the time at which this session expires, e.g. to keep it alive while it's used
+     * 
+     * May be called by endpoints while the sessionStore looks at the session from another thread.
+     */
+  void setExpireTime(std::chrono::time_point<std::chrono::system_clock> time);
+
+  /**
+     * @brief Let the session expire timeout minutes from now
+     * 
+     */
+  void extend(unsigned int timeout);
+
+private:
+  friend class sessionStore;
+
+  // The expiry in nanoseconds since the epoch of the system clock, atomic as endpoints move it while the store reads it
+  std::atomic<int64_t> expireTime;
+
+  // The store and every request using the session hold a reference, the last one to let go destroys it
+  std::atomic<unsigned int> references{0};
+};
+} // namespace kleins
+
+#endif 
+#ifndef SESSIONPOOL_H
+#define SESSIONPOOL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../sessionBase/sessionBase.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief What the sessionStore returns expired sessions to, whatever class they are
+ */
+class sessionPoolBase {
+public:
+  static const unsigned int shardCount = 16;
+
+  virtual ~sessionPoolBase();
+
+  /**
+   * @brief Destroy a session of this pool and make its memory available to the next one
+   */
+  virtual void release(sessionBase* session) = 0;
+
+  /**
+   * @brief Destroy a session, returning it to its pool or deleting it if it doesn't have one
+   */
+  static void destroy(sessionBase* session);
+
+protected:
+  /**
+   * @brief The shard of the calling thread, threads are spread over the shards round robin
+   */
+  static unsigned int threadShard();
+};
+
+/**
+ * @brief Allocates the sessions of one class from slabs of slots.
+ *
+ * Sessions are placed into the free slots of slabs holding slabCapacity of them, so they sit next to each other instead of all over the heap,
+ * and expired sessions leave their slot to the next one instead of going back to the general purpose allocator.
+ * Free slots are kept in a list per shard of threads, so threads creating and releasing sessions at the same time rarely wait for each other.
+ * A thread whose list ran empty takes over the list of another shard before a new slab is allocated, as sessions are mostly released
+ * by another thread than the one that created them.
+ * Slabs are kept until the pool is destroyed, which has to happen after all of its sessions were released.
+ */
+template <class T>
+class sessionPool : public sessionPoolBase {
+public:
+  static const size_t slabCapacity = 64;
+
+private:
+  union slot {
+    slot* next;
+    alignas(T) unsigned char object[sizeof(T)];
+  };
+
+  struct alignas(64) freeList {
+    std::mutex mutex;
+
+    // Chained through the next pointer of the free slots
+    slot* slots = 0;
+  };
+
+  freeList freeLists[shardCount];
+
+  std::mutex slabMutex;
+  std::vector<std::unique_ptr<slot[]>> slabs;
+
+  // Take the free slots of another shard. Shards that are locked right now are skipped, waiting for them could deadlock with their thread stealing back.
+  slot* stealSlots(unsigned int shard) {
+    for (unsigned int i = 1; i < shardCount; i++) {
+      freeList& other = freeLists[(shard + i) % shardCount];
+      std::unique_lock<std::mutex> lock(other.mutex, std::try_to_lock);
+
+      if (lock.owns_lock() && other.slots) {
+        slot* stolen = other.slots;
+        other.slots = 0;
+        return stolen;
+      }
+    }
+
+    return 0;
+  }
+
+  slot* newSlab() {
+    std::lock_guard<std::mutex> lock(slabMutex);
+
+    slabs.emplace_back(new slot[slabCapacity]);
+    slot* slab = slabs.back().get();
+
+    for (size_t i = 0; i < slabCapacity; i++) {
+      slab[i].next = i + 1 < slabCapacity ? &slab[i + 1] : 0;
+    }
+
+    return slab;
+  }
+
+  slot* takeSlot() {
+    unsigned int shard = threadShard();
+    freeList& own = freeLists[shard];
+
+    std::lock_guard<std::mutex> lock(own.mutex);
+
+    if (!own.slots) {
+      own.slots = stealSlots(shard);
+    }
+
+    if (!own.slots) {
+      own.slots = newSlab();
+    }
+
+    slot* taken = own.slots;
+    own.slots = taken->next;
+
+    return taken;
+  }
+
+  void returnSlot(slot* freed) {
+    freeList& own = freeLists[threadShard()];
+
+    std::lock_guard<std::mutex> lock(own.mutex);
+
+    freed->next = own.slots;
+    own.slots = freed;
+  }
+
+public:
+  sessionPool() {
+  }
+
+  sessionPool(const sessionPool&) = delete;
+  sessionPool& operator=(const sessionPool&) = delete;
+
+  /**
+   * @brief Construct a session in a free slot
+   */
+  T* create() {
+    slot* free = takeSlot();
+    T* session;
+
+    try {
+      session = new (free->object) T();
+    } catch (...) {
+      returnSlot(free);
+      throw;
+    }
+
+    session->pool = this;
+    return session;
+  }
+
+  void release(sessionBase* session) override {
+    T* object = static_cast<T*>(session);
+    object->~T();
+
+    returnSlot(reinterpret_cast<slot*>(object));
+  }
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <openssl/rand.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#ifndef SINGLE_HEADER
+#include "../sessionBase/sessionBase.h"
+#include "../sessionPool/sessionPool.h"
+#include "../timerWheel/timerWheel.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief The sessions of an httpServer, by their key.
+ *
+ * The sessions are spread over shards by the hash of their key, every shard has its own lock, so threads looking up different sessions
+ * rarely wait for each other. Each shard keeps a timerWheel with a timer per session, ticking once per second,
+ * so expiring sessions only costs something for the sessions that actually expire. The map is keyed by the key stored in the session itself
+ * and takes its nodes from a pool of the shard, so storing a session doesn't reach the general purpose allocator.
+ *
+ * Sessions are reference counted. The store holds one reference while the session is stored, find and add hand out one more
+ * to the caller, which gives it back with release. An expired session is taken out of the store with the next expire,
+ * and destroyed once the last request that looked it up let go of it.
+ */
+class sessionStore {
+public:
+  static const size_t shardCount = 64;
+
+private:
+  struct entry : timerWheel::timer {
+    sessionBase* session = 0;
+  };
+
+  struct alignas(64) shard {
+    std::mutex mutex;
+    std::pmr::unsynchronized_pool_resource nodes;
+    std::pmr::unordered_map<std::string_view, entry> sessions;
+    timerWheel expiry;
+
+    shard();
+  };
+
+  shard shards[shardCount];
+  std::atomic<size_t> sessionCount{0};
+
+  shard& shardOf(std::string_view key);
+
+  static uint64_t currentSecond();
+
+  // The second the session is taken out of the store in, the first one after its expireTime
+  static uint64_t expirySecond(const sessionBase* session);
+
+public:
+  sessionStore();
+
+  /**
+   * @brief Lets go of every session that is left, they are destroyed unless a request still holds them
+   */
+  ~sessionStore();
+
+  sessionStore(const sessionStore&) = delete;
+  sessionStore& operator=(const sessionStore&) = delete;
+
+  /**
+   * @brief Look up a session
+   *
+   * @return The session, 0 if there is none with this key or it expired. The caller holds a reference to it, see release.
+   */
+  sessionBase* find(std::string_view key);
+
+  /**
+   * @brief Store a new session under a random key, which the session's sessionKey points to afterwards
+   *
+   * @param session The session, the store takes ownership and destroys it after it expired, see sessionPoolBase::destroy.
+   * The caller holds a reference to it, like one returned by find.
+   */
+  void add(sessionBase* session);
+
+  /**
+   * @brief Store a session under a given key, e.g. one restored from a sessionSnapshot
+   *
+   * @return false if the key is taken or isn't sessionBase::keyLength long, the session isn't stored then and the caller still owns it
+   */
+  bool add(sessionBase* session, std::string_view key);
+
+  /**
+   * @brief Give back the reference to a session returned by find or add. May be called from any thread.
+   */
+  static void release(sessionBase* session);
+
+  /**
+   * @brief Call visitor with every session that didn't expire yet. Each shard is locked while its sessions are visited.
+   */
+  void forEach(const std::function<void(std::string_view key, const sessionBase* session)>& visitor);
+
+  /**
+   * @brief Take the sessions that expired out of the store. Sessions whose expireTime was pushed back meanwhile are kept.
+   *
+   * @return The amount of sessions taken out
+   */
+  size_t expire();
+
+  /**
+   * @brief The amount of stored sessions, including expired ones that weren't taken out yet
+   */
+  size_t size();
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef SESSIONSNAPSHOT_H
+#define SESSIONSNAPSHOT_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../sessionBase/sessionBase.h"
+#include "../sessionStore/sessionStore.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief A file holding the sessions of an httpServer, so they survive a restart.
+ *
+ * The file starts with an index of all sessions sorted by key, each with its expireTime and where its data is, followed by the data
+ * the sessions wrote with sessionBase::serialize. A snapshot left by the previous run is mapped into memory as it is,
+ * nothing is read up front. A session is only looked up in it and restored when a request comes in with its key.
+ *
+ * Writing a snapshot puts the live sessions and the ones of the previous snapshot that weren't restored yet into a new file,
+ * which then replaces the old one. The file is only meant to be read back by the same build on the same machine.
+ */
+class sessionSnapshot {
+public:
+  static const size_t keyLength = sessionBase::keyLength;
+
+  /**
+   * @brief A session of the snapshot. The data points into the mapped file and stays valid as long as the sessionSnapshot.
+   */
+  struct record {
+    std::chrono::time_point<std::chrono::system_clock> expireTime;
+    std::string_view data;
+  };
+
+private:
+  struct fileHeader {
+    char magic[8];
+    uint64_t count;
+  };
+
+  struct indexEntry {
+    char key[keyLength];
+    int64_t expireTime;
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  static constexpr char magic[8] = {'K', 'H', 'S', 'E', 'S', 'S', '1', 0};
+
+  std::string path;
+
+  const char* mapping = 0;
+  size_t mappingSize = 0;
+
+  const indexEntry* index = 0;
+  size_t count = 0;
+
+  // Guards taken, which marks the sessions of the mapped snapshot that were restored
+  std::mutex mutex;
+  std::vector<bool> taken;
+
+  // Guards writing the file
+  std::mutex writeMutex;
+
+  bool map();
+  const indexEntry* lookup(std::string_view key);
+
+  static int64_t toNanoseconds(std::chrono::time_point<std::chrono::system_clock> time);
+
+public:
+  /**
+   * @brief Use a snapshot file, mapping the snapshot the previous run left there if there is one
+   *
+   * @param filePath Where the snapshot is stored, it's written to filePath + ".tmp" first
+   */
+  sessionSnapshot(const std::string& filePath);
+  ~sessionSnapshot();
+
+  sessionSnapshot(const sessionSnapshot&) = delete;
+  sessionSnapshot& operator=(const sessionSnapshot&) = delete;
+
+  /**
+   * @brief Take a session out of the mapped snapshot, to restore it. Each session can only be taken once.
+   *
+   * @return false if the snapshot has no session with this key that didn't expire yet, or it was taken already
+   */
+  bool take(std::string_view key, record& saved);
+
+  /**
+   * @brief Write the sessions of a store and the ones of the mapped snapshot that weren't taken yet into the snapshot file
+   *
+   * @return false if the file couldn't be written, the previous one is kept then
+   */
+  bool write(sessionStore& store);
+
+  /**
+   * @brief The amount of sessions in the mapped snapshot
+   */
+  size_t size();
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef RESPONSEWRITER_H
+#define RESPONSEWRITER_H
+
+#include <list>
+#include <string>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief Sends the body of a response piece by piece, obtained from httpParser::respondChunked after the headers went out.
+ *
+ * Writes are collected into chunks of up to chunkSize bytes of a chunked body. Writes from a worker pool thread wait while the client
+ * is more than maxPendingBytes behind, so producing a large response takes constant memory.
+ * Writes on the I/O thread can't wait, there unsent data is buffered.
+ */
+class responseWriter {
+private:
+  connectionBase* connsocket;
+
+  bool chunked;
+  bool ended = false;
+
+  // Small writes are collected into one chunk
+  std::string buffer;
+
+  // Bytes sent since the last time the writer checked how far behind the client is
+  size_t uncheckedBytes = 0;
+
+public:
+  /**
+   * @param conn The connection to write to
+   * @param useChunks Whether to use the chunked encoding. Without it the body ends when the connection is closed, for HTTP/1.0 clients.
+   */
+  responseWriter(connectionBase* conn, bool useChunks = true);
+
+  /**
+   * @brief Ends the response if end() wasn't called
+   */
+  ~responseWriter();
+
+  /**
+   * @brief How far the client may fall behind before writes wait for it
+   */
+  size_t maxPendingBytes = 256 * 1024;
+
+  /**
+   * @brief Writes are held back until this many bytes came together, unless flush() is called
+   */
+  size_t chunkSize = 16 * 1024;
+
+  void write(const char* data, size_t length);
+  void write(const std::string& data);
+
+  /**
+   * @brief Send everything written so far right away
+   */
+  void flush();
+
+  /**
+   * @brief Finish the response
+   *
+   * @param trailers Header lines sent after the body ("Name: value"). They should be announced in a Trailer header of the response.
+   */
+  void end(const std::list<std::string>& trailers = {});
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef SSLSOCKET_T
+#define SSLSOCKET_T
+
+#include <arpa/inet.h>
+#include <future>
+#include <iostream>
+#include <netinet/in.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../socketBase/socketBase.h"
+#include "../sslConnection/sslConnection.h"
+#endif
+
+namespace kleins {
+class sslSocket : public socketBase {
+private:
+  std::vector<int> socketfds;
+  struct sockaddr_in address;
+
+  SSL_CTX* ctx;
+
+  bool tick(unsigned int shard);
+  void interruptTicks();
+
+public:
+  /**
+   * @brief Construct a new ssl socket
+   *
+   * @param listenAddress The address to listen on
+   * @param listenPort The port to listen on
+   * @param pathToCertificate Path to the PEM certificate
+   * @param pathToKey Path to the PEM private key
+   * @param listenOptions Sharding, backlog and accept tuning of the listener
+   */
+  sslSocket(
+      const char* listenAddress, const int listenPort, const char* pathToCertificate, const char* pathToKey,
+      const listenerOptions& listenOptions = listenerOptions());
+  ~sslSocket();
+
+  std::future<bool> init();
+};
+
+}; // namespace kleins
+
+#endif
+ 
+#ifndef HTTPPARSER_H
+#define HTTPPARSER_H
+
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <regex>
+#include <list>
+#include <string_view>
+#include <strings.h>
+#include <vector>
+
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#include "../httpServer/httpServer.h"
+#include "../packet/packet.h"
+#include "../responseBuilder/responseBuilder.h"
+#include "../responseWriter/responseWriter.h"
+#include "../router/router.h"
+#include "../scanner/scanner.h"
+#include "../sessionBase/sessionBase.h"
+#include "../sessionStore/sessionStore.h"
+#include "../staticFile/staticFile.h"
+#endif
+
+namespace kleins {
+class httpServer;
+
+class httpParser {
+public:
+  /**
+   * @brief A header or parameter of the request. Both parts point into the received request.
+   */
+  struct requestField {
+    std::string_view name;
+    std::string_view value;
+  };
+
+private:
+  // The fields of a request in the order they were sent. The first ones are stored inline, only unusually large requests spill onto the heap.
+  struct fieldList {
+    static const size_t inlineCapacity = 32;
+
+    requestField inlineFields[inlineCapacity];
+    std::pmr::vector<requestField> spilledFields;
+    size_t count = 0;
+
+    fieldList(std::pmr::memory_resource* memory);
+
+    void add(std::string_view name, std::string_view value);
+    const requestField& operator[](size_t index) const;
+  };
+
+  std::string_view request;
+  connectionBase* connsocket;
+
+  // Where everything the parser needs during the request is allocated from
+  std::pmr::memory_resource* memory;
+
+  httpServer* server;
+
+  router::routeMatch route;
+  bool routeLookedUp = false;
+
+  // The session the endpoint started, held until the parser is destroyed
+  sessionBase* session = 0;
+
+  // What is reserved for a response head, and the biggest body that is copied behind the head to send both at once
+  static const size_t responseHeadSize = 512;
+  static const size_t maxCopiedBodySize = 16 * 1024;
+
+  // The headers every response carries: the ones passed by the endpoint, keep-alive, Date, Server and the session cookie
+  template <class headerList>
+  void writeCommonHeaders(responseBuilder& response, const headerList& responseHeaders);
+
+  // The headers that differ from request to request: keep-alive, Date and the session cookie
+  void writeRequestHeaders(responseBuilder& response);
+
+  void sendResponse(responseBuilder& response, const char* body, size_t bodyLength);
+
+  fieldList headerFields;
+  fieldList parameterFields;
+
+  // Copies of the fields for getHeaders and getParameters, only built when asked for
+  std::map<std::string, std::string> headerMap;
+  std::map<std::string, std::string> parameterMap;
+  bool headerMapBuilt = false;
+  bool parameterMapBuilt = false;
+
+  inline void parseRequestline();
+  inline void parseHeaders();
+
+  void parseURLencodedData(std::string_view rawData);
+
+public:
+  /**
+   * @brief Create a parser for one request
+   *
+   * @param request The head of the request followed by its body, it has to outlive the parser
+   * @param requestMemory Where the parser allocates from, e.g. the requestArena of the connection
+   */
+  httpParser(std::string_view request, connectionBase* conn, httpServer* srv, std::pmr::memory_resource* requestMemory = std::pmr::get_default_resource());
+  ~httpParser();
+
+  /**
+   * @brief Parse the request and call the endpoint it is for
+   */
+  bool parse();
+
+  /**
+   * @brief Only parse the request line, headers and whatever body the request holds, without calling an endpoint
+   */
+  bool parseHead();
+
+  /**
+   * @brief Call the endpoint the parsed request is for, or respond with a 404
+   */
+  void dispatch();
+
+  /**
+   * @brief Start a session of class T for the client, or continue the one its cookie names
+   *
+   * @return The session, it stays valid until the parser is destroyed. Keep the data to use beyond the request in the session, not the pointer.
+   */
+  template <class T>
+  sessionBase* startSession();
+
+  /**
+   * @brief Look up the endpoint the request is for, only done once per request
+   *
+   * @return The route of the endpoint, 0 if there is none
+   */
+  const router::route* matchRoute();
+
+  void respond(const std::string& status, const std::list<std::string>& responseHeaders, std::string_view body, const std::string& mimeType = "text/html");
+  void respond(const std::string& status, const std::list<std::string>& responseHeaders, const char* body, size_t bodyLength,
+      const std::string& mimeType = "text/html");
+
+  /**
+   * @brief Like respond, without allocating for the status or the headers
+   *
+   * @param status The status code, the reason phrase is added for known codes
+   * @param responseHeaders Complete header lines, e.g. "Cache-Control: no-cache"
+   */
+  void respond(unsigned int status, std::string_view body, std::string_view mimeType = "text/html", std::initializer_list<std::string_view> responseHeaders = {});
+
+  /**
+   * @brief Send a response that was serialized ahead of time, in one write. Only the status line and the headers depending on the request are added.
+   *
+   * @param serialized The rest of the head including its empty line, followed by the body. It's copied, so it may be shared between threads.
+   */
+  void respondSerialized(unsigned int status, std::string_view serialized);
+
+  /**
+   * @brief Respond with memory shared with other owners as the body, like a mapped file. The body isn't copied, it's held until it was sent.
+   */
+  void respondShared(const std::string& status, const std::list<std::string>& responseHeaders, std::shared_ptr<const char> body, size_t bodyLength,
+      const std::string& mimeType = "text/html");
+
+  /**
+   * @brief Respond with a range of an open file as the body. The body is sent straight from the file without copying it through userspace where the connection supports it.
+   *
+   * @param filefd The file, it has to stay open until the response is sent
+   * @param offset The first byte of the file to send
+   * @param length The amount of bytes to send
+   * @param fileOwner Whatever keeps the file open, it's held until the response is sent
+   */
+  void respondFile(const std::string& status, const std::list<std::string>& responseHeaders, int filefd, off_t offset, size_t length,
+      const std::string& mimeType = "text/html", std::shared_ptr<const void> fileOwner = std::shared_ptr<const void>());
+
+  /**
+   * @brief Send the headers of a response right away and stream its body through the returned writer, in the chunked encoding.
+   * HTTP/1.0 clients get the body unencoded and the connection is closed after it.
+   *
+   * The response has to be finished before the endpoint returns, which the writer does when it goes out of scope.
+   */
+  std::unique_ptr<responseWriter> respondChunked(const std::string& status, const std::list<std::string>& responseHeaders, const std::string& mimeType = "text/html");
+
+  /**
+   * @brief Respond with several ranges of an open file as a 206 multipart/byteranges body. Like respondFile the ranges are sent straight from the file.
+   *
+   * @param fileSize The size of the whole file, used in the Content-Range of every part
+   * @param ranges The ranges to send, in the order they are sent
+   */
+  void respondFileRanges(const std::list<std::string>& responseHeaders, int filefd, size_t fileSize, const std::vector<staticFile::byteRange>& ranges,
+      const std::string& mimeType = "text/html", std::shared_ptr<const void> fileOwner = std::shared_ptr<const void>());
+
+  /**
+   * @brief Respond with a body-less 304, telling the client its cached copy is still current
+   *
+   * @param responseHeaders The validators (ETag, Last-Modified) and caching headers the full response would have carried
+   */
+  void respondNotModified(const std::list<std::string>& responseHeaders);
+
+  /**
+   * @brief The value of a header, its name is compared case insensitively. Empty if the request doesn't have it.
+   */
+  std::string_view getHeader(std::string_view name);
+
+  /**
+   * @brief The value of a parameter from the query string or a form body. Empty if the request doesn't have it.
+   */
+  std::string_view getParameter(std::string_view name);
+
+  /**
+   * @brief The part of the path matched by a ':' or '*' segment of the endpoint's route. Empty if the route has no such parameter.
+   */
+  std::string_view getRouteParameter(std::string_view name);
+
+  size_t getHeaderCount();
+  const requestField& getHeaderField(size_t index);
+
+  size_t getParameterCount();
+  const requestField& getParameterField(size_t index);
+
+  /**
+   * @brief The headers as a map of copies, for handlers written against the old interface. Built on the first call.
+   */
+  std::map<std::string, std::string>& getHeaders();
+
+  /**
+   * @brief The parameters as a map of copies, for handlers written against the old interface. Built on the first call.
+   */
+  std::map<std::string, std::string>& getParameters();
+
+  static bool equalsIgnoreCase(std::string_view first, std::string_view second);
+
+  // The parts of the request point into the received request, which lives as long as the parser.
+  // Copy them to keep them beyond the endpoint.
+  std::string_view requestline;
+  std::string_view header;
+  std::string_view body;
+
+  // The key of the session the endpoint started, empty if it didn't start one
+  std::string_view sessionKey;
+
+  /**
+   * @brief Set when the response can only be delimited by closing the connection, keep-alive is then ignored
+   */
+  bool closeConnection = false;
+
+  /**
+   * @brief For endpoints added with httpServer::onStream. Called with every piece of the request body as it arrives, body stays empty.
+   * Reading from the connection waits while it runs.
+   */
+  std::function<void(const char* data, size_t length)> onBodyChunk;
+
+  /**
+   * @brief For endpoints added with httpServer::onStream. Called once the whole body went through onBodyChunk, this is where the response is sent.
+   * It isn't called if the connection fails before the body is complete.
+   */
+  std::function<void()> onBodyEnd;
+
+  std::string_view method;
+  std::string_view path;
+  std::string_view query;
+};
+} // namespace kleins
+
+#endif
+ 
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <openssl/rand.h>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#include "../counterMetric/counterMetric.h"
+#include "../eventLoop/eventLoop.h"
+#include "../fileCache/fileCache.h"
+#include "../gaugeMetric/gaugeMetric.h"
+#include "../histogramMetric/histogramMetric.h"
+#include "../httpParser/httpParser.h"
+#include "../packet/packet.h"
+#include "../requestArena/requestArena.h"
+#include "../requestReader/requestReader.h"
+#include "../routeTable/routeTable.h"
+#include "../router/router.h"
+#include "../sessionBase/sessionBase.h"
+#include "../sessionPool/sessionPool.h"
+#include "../sessionSnapshot/sessionSnapshot.h"
+#include "../sessionStore/sessionStore.h"
+#include "../socketBase/socketBase.h"
+#include "../staticFile/staticFile.h"
+#include "../tcpSocket/tcpSocket.h"
+#include "../workerPool/workerPool.h"
+#endif
+
+#ifndef BUILD_VERSION
+#define BUILD_VERSION "UNKNOWN"
+#endif
+
+namespace kleins {
+
+class httpParser;
+
+/**
+ * @brief An httpserver that will take care of connection managment, serving of static files and api endpoints
+ * 
+ * 
+ * 
+ */
+class httpServer {
+  friend class httpParser;
+
+private:
+  // A pool for every class sessions are started with. Declared before the sessions, which are returned to them when they are destroyed.
+  std::unordered_map<std::type_index, std::unique_ptr<sessionPoolBase>> sessionPools;
+  std::mutex sessionPoolMutex;
+
+  template <class T> sessionPool<T>* getSessionPool();
+
+  sessionStore sessions;
+
+  // Set once by setSessionSnapshot, the cleanup thread writes it every snapshotInterval seconds
+  std::atomic<sessionSnapshot*> snapshot{0};
+  unsigned int snapshotInterval = 0;
+
+  std::thread* sessionCleanupThread;
+  static void cleanUpSessionLoop(httpServer* server);
+
+  bool keepRunning = true;
+
+  std::list<std::unique_ptr<socketBase>> sockets;
+
+  eventLoop* loop = 0;
+  workerPool* pool = 0;
+
+  router routes;
+
+  // A table added with on(routeTable), dispatched through a plain function that knows its type
+  struct compiledRouteTable {
+    const void* table;
+    bool (*dispatch)(const void* table, httpParser* parser);
+  };
+
+  template <class table> static bool dispatchRouteTable(const void* routes, httpParser* parser);
+
+  // The tables added with on(routeTable) and every list of them published so far, the newest table first. Adding a table publishes a new
+  // list instead of changing the current one, the old ones are kept until the server is destroyed because requests may still be walking them.
+  std::list<std::shared_ptr<const void>> routeTableStorage;
+  std::list<std::vector<compiledRouteTable>> routeTables;
+  std::atomic<const std::vector<compiledRouteTable>*> compiledRoutes{0};
+  std::mutex routeTableMutex;
+  std::list<std::unique_ptr<staticFile>> staticFiles;
+  fileCache* cache = 0;
+
+  void newConnection(connectionBase* conn);
+  requestLimits limits;
+  connectionTimeouts timeouts;
+
+  // Tells keep-alive clients the idle timeout, so they don't reuse a connection the server is about to close
+  std::string keepAliveHeader = "Keep-Alive: timeout=30";
+
+  // Whether any endpoint was added with onStream, requests only have to be checked for one then
+  bool hasStreamRoutes = false;
+
+  // A request for an onStream endpoint whose body is still coming in
+  struct streamedRequest {
+    packet head;
+    std::unique_ptr<httpParser> parser;
+  };
+
+  // Which read deadline of the connection is running for the request it is receiving
+  enum readPhase {
+    READ_PHASE_IDLE,
+    READ_PHASE_HEAD,
+    READ_PHASE_BODY,
+  };
+
+  // What a connection has read of the request it is currently receiving
+  struct connectionState {
+    requestReader reader;
+    std::shared_ptr<streamedRequest> stream;
+    readPhase phase = READ_PHASE_IDLE;
+
+    // Holds the request being handled and its parser, emptied once it is answered
+    requestArena arena;
+  };
+
+  void processInput(connectionBase* conn, std::shared_ptr<connectionState> state);
+  bool runRequestStep(connectionBase* conn, std::shared_ptr<connectionState> state, std::function<bool()> step);
+  std::shared_ptr<streamedRequest> startStream(connectionBase* conn, const std::string& head);
+  bool handleRequest(connectionBase* conn, connectionState* state, std::string_view request);
+  bool finishRequest(connectionBase* conn, httpParser* parser);
+  void rejectRequest(connectionBase* conn, requestReader::readState error);
+  void setReadPhase(connectionBase* conn, connectionState* state, readPhase phase);
+  void serveFile(httpParser* parser, staticFile* file);
+  void addRoute(httpMethod method, const std::string& uri, const std::function<void(httpParser*)> callback, bool streamed, bool patterns);
+
+  static std::map<std::string, std::string> mimeLookup;
+
+  httpServer* mServer = 0;
+
+  metrics::counterMetric* metric_totalAcccess = 0;
+  metrics::histogramMetric* metric_access = 0;
+  metrics::counterMetric* metric_totalSessions = 0;
+  metrics::gaugeMetric* metric_activeSessions = 0;
+
+public:
+  /**
+   * @brief httpServer constructor
+   * 
+   * @param ioThreads The amount of threads that handle connections. 0 uses one per core.
+   */
+  httpServer(unsigned int ioThreads = 0);
+
+  /**
+   * @brief Destroy the http Server object
+   * 
+   */
+  ~httpServer();
+
+  /**
+   * @brief Add an endpoint to the httpServer
+   * 
+   * @param method The method of the endpoint
+   * @param uri The url to respond to on ('/', 'api/hello'). Segments starting with ':' match any segment and a last segment starting with '*'
+   * matches the rest of the path ('/users/:id', or '*path' as the last segment of '/files'), the endpoint gets them from parser->getRouteParameter.
+   * @param callback The callback function that gets triggered when a client acces it.
+   * 
+   * Example:
+   * 
+   * \code{.cpp}
+   * server.on(kleins::httpMethod::GET,"/hello",[](httpParser* parser){
+   *    data->respond("200",{},"Hello!");
+   * });
+   *
+   * server.on(kleins::httpMethod::GET,"/users/:id",[](httpParser* parser){
+   *    parser->respond("200",{},parser->getRouteParameter("id"));
+   * });
+   * \endcode
+   */
+  void on(httpMethod method, const std::string& uri, const std::function<void(httpParser*)> callback);
+
+  /**
+   * @brief Add the endpoints of a routeTable, which dispatches without going through std::function or the route tree.
+   * They are looked up before the endpoints added with on(method, uri, callback), tables added later before the ones added earlier.
+   * Requests to them are counted in the total of the metrics server, but not per handler.
+   */
+  template <class... handlers>
+  void on(const routeTable<handlers...>& table);
+
+  /**
+   * @brief Add an endpoint that receives the request body piece by piece while it arrives instead of all at once
+   *
+   * The callback runs as soon as the headers are in. It sets parser->onBodyChunk, which then gets every piece of the body,
+   * and parser->onBodyEnd, which responds once the body is complete. Reading from the connection waits while either runs,
+   * so a slow consumer holds back the client instead of the body piling up in memory. requestLimits::maxBodySize doesn't apply.
+   *
+   * Example:
+   *
+   * \code{.cpp}
+   * server.onStream(kleins::httpMethod::POST, "/upload", [](httpParser* parser) {
+   *    auto file = std::make_shared<std::ofstream>("upload.bin", std::ios::binary);
+   *    parser->onBodyChunk = [file](const char* data, size_t length) { file->write(data, length); };
+   *    parser->onBodyEnd = [parser]() { parser->respond("200", {}, "Stored"); };
+   * });
+   * \endcode
+   */
+  void onStream(httpMethod method, const std::string& uri, const std::function<void(httpParser*)> callback);
+
+  /**
+   * @brief Serve a localfile under a path
+   *
+   * The response for files up to 16 KiB is put together here, headers and content, and sent with a single write on every request.
+   * Bigger files are sent from the file cache or straight from disk.
+   *
+   * The file is read once here and closed again, it only takes a descriptor while responses are sending it from disk,
+   * one per file however many responses send it at once. The file shouldn't change while it's served, responses for it fail with a 500 then.
+   *
+   * @param uri The url the file should be provided under
+   * @param path The local path of the file
+   * @param cacheControl The Cache-Control header to send with the file, e.g. "public, max-age=31536000, immutable" for fingerprinted files.
+   * None is sent if it's empty, clients then revalidate with the ETag or Last-Modified date.
+   */
+  void serve(const std::string& uri, const std::string& path, const std::string& cacheControl = "");
+
+  /**
+   * @brief Automaticly serve a directory recursivly
+   * 
+   * @param baseuri The parent path of all the files ('/','static/')
+   * @param path The path of the local files to be served
+   * @param indexFile Set the name of the index files that will also be avaliable under /
+   * @param cacheControl The Cache-Control header to send with all files of the directory, see serve()
+   *
+   * Every file is read once, the files don't stay open, so directories with more files than the descriptor limit can be served. See serve().
+   */
+  void serveDirectory(const std::string& baseuri, const std::string& path, const std::string indexFile = "index.html", const std::string& cacheControl = "");
+
+  /**
+   * @brief Add a socket to listen on
+   * 
+   * @param socket A pointer to a socket that should be used. \n It should be noted that it the socket will be delted when the server object gets deleted.
+   * @return true 
+   * @return false 
+   */
+  bool addSocket(socketBase* socket);
+
+  /**
+   * @brief Print the version of kleinsHTTP to the stdout
+   * 
+   */
+  void printVersion();
+
+  void startMetricsServer(uint16_t port);
+
+  /**
+   * @brief Set the size limits for requests on connections accepted from now on
+   */
+  void setRequestLimits(const requestLimits& serverLimits);
+
+  /**
+   * @brief Set the timeouts of connections accepted from now on
+   *
+   * Clients that send the head of a request slower than the header timeout, or its body slower than the body timeout, are disconnected,
+   * however much they trickle in. Keep-alive responses announce the idle timeout in their Keep-Alive header.
+   */
+  void setConnectionTimeouts(const connectionTimeouts& serverTimeouts);
+
+  /**
+   * @brief Run endpoint callbacks on a pool of worker threads instead of the threads doing the I/O
+   *
+   * Slow callbacks then only hold up their own request, and the amount of callbacks running at once is capped at the pool size.
+   * Connections of sockets that drive their own I/O (uringSocket) are still handled inline.
+   *
+   * @param threadCount The amount of worker threads. 0 uses one per core.
+   */
+  void startWorkerPool(unsigned int threadCount = 0);
+
+  /**
+   * @brief Configure the cache that keeps small, frequently requested static files mapped in memory
+   *
+   * Files that aren't cached are sent straight from disk. The cache starts out with a 64 MiB budget and caches files up to 1 MiB.
+   *
+   * @param budgetBytes The amount of memory all cached files may take up together, least recently used files are evicted beyond it. 0 disables the cache.
+   * @param maxFileSizeBytes Files bigger than this are never cached
+   */
+  void setFileCache(size_t budgetBytes, size_t maxFileSizeBytes = 1024 * 1024);
+
+  /**
+   * @brief Keep the sessions in a snapshot file, so users stay logged in when the server restarts
+   *
+   * The sessions of the snapshot the previous run left there aren't read up front. Each one is restored when the first request with its key
+   * starts a session, through sessionBase::deserialize of the class that request starts. Call it once, before the server gets requests.
+   *
+   * @param path The snapshot file
+   * @param intervalSeconds How often the snapshot is written. 0 only writes it when the server is destroyed.
+   */
+  void setSessionSnapshot(const std::string& path, unsigned int intervalSeconds = 60);
+
+  metrics::counterMetric* metric_notfound = 0;
+
+  /**
+   * @brief Continue the session stored under authKey, or start a new one of class T. Endpoints use httpParser::startSession instead.
+   *
+   * @return The session, the caller holds a reference to it and gives it back with sessionStore::release
+   */
+  template <class T> sessionBase* startSession(std::string_view authKey);
+};
+
+}; // namespace kleins
+
+#endif
+ 
+#ifndef TCPSOCKET_H
+#define TCPSOCKET_H
+
+#include <arpa/inet.h>
+#include <future>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../socketBase/socketBase.h"
+#include "../tcpConnection/tcpConnection.h"
+#endif
+
+namespace kleins {
+class tcpSocket : public socketBase {
+private:
+  std::vector<int> socketfds;
+  struct sockaddr_in address;
+
+  bool tick(unsigned int shard);
+  void interruptTicks();
+
+public:
+  /**
+   * @brief Construct a new tcp socket
+   *
+   * @param listenAddress The address to listen on
+   * @param listenPort The port to listen on
+   * @param listenOptions Sharding, backlog and accept tuning of the listener
+   */
+  tcpSocket(const char* listenAddress, const int listenPort, const listenerOptions& listenOptions = listenerOptions());
+  ~tcpSocket();
+
+  std::future<bool> init();
+};
+
+}; // namespace kleins
+
+#endif
+ 
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <cerrno>
+#include <fcntl.h>
+#include <future>
+#include <iostream>
+#include <list>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#include "../packet/packet.h"
+#endif
+
+namespace kleins {
+class tcpConnection : public connectionBase {
+private:
+  int connectionfd;
+
+protected:
+  virtual ssize_t writeSome(const char* data, size_t length);
+  virtual ssize_t sendFileSome(int filefd, off_t offset, size_t length);
+
+public:
+  tcpConnection(int connectionid);
+  ~tcpConnection();
+
+  virtual bool getAlive();
+  virtual int getFd();
+  virtual void tick();
+  virtual void close_socket();
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <cerrno>
+#include <fcntl.h>
+#include <future>
+#include <iostream>
+#include <list>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#include "../packet/packet.h"
+#endif
+
+namespace kleins {
+class sslConnection : public connectionBase {
+private:
+  int connectionfd;
+  SSL_CTX* ctx;
+  SSL* ossl;
+  bool handshakeDone = false;
+  bool handshakeWantsWrite = false;
+
+  bool handleSSLError(int returnValue);
+
+  /**
+   * @brief Take the TLS handshake as far as the socket allows without blocking
+   *
+   * @return Whether the handshake is done
+   */
+  bool continueHandshake();
+
+protected:
+  virtual ssize_t writeSome(const char* data, size_t length);
+
+public:
+  sslConnection(int connectionid, SSL_CTX* sslcontext);
+  ~sslConnection();
+
+  virtual bool getAlive();
+  virtual int getFd();
+  virtual void tick();
+  virtual void flush();
+  virtual void close_socket();
+
+  virtual bool hasPendingOutput();
+  virtual bool handshakePending();
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef METRICSERVER_H
+#define METRICSERVER_H
+
+#ifndef SINGLE_HEADER
+#include "../httpServer/httpServer.h"
+#include "../metricBase/metricBase.h"
+
+#endif
+
+namespace kleins {
+
+namespace metrics {
+
+class metricsServer : public kleins::httpServer {
+private:
+  /* data */
+
+  std::list<metricBase*> metrics;
+
+public:
+  void addMetric(metricBase* metric);
+
+  metricsServer(/* args */);
+  ~metricsServer();
+};
+
+} // namespace metrics
+} // namespace kleins
+
+#endif 
+#ifndef METRICBASE_H
+#define METRICBASE_H
+
+#include <memory>
+
+namespace kleins {
+
+namespace metrics {
+
+class metricBase {
+protected:
+  const char* helpString = "";
+  const char* nameString = "";
+
+public:
+  metricBase(/* args */);
+  ~metricBase();
+
+  virtual const char* getType() = 0;
+
+  void setHelp(const char* help);
+  void setName(const char* name);
+
+  virtual std::unique_ptr<char*> construct() = 0;
+};
+
+} // namespace metrics
+
+} // namespace kleins
+
+#endif 
+#ifndef SHARDEDCOUNTER_H
+#define SHARDEDCOUNTER_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace kleins {
+
+namespace metrics {
+
+/**
+ * @brief A counter that many threads can add to at once without losing counts or fighting over one cache line.
+ *
+ * The count is split over shardCount cells on cache lines of their own. Every thread adds to the cell it was given the first time it counted,
+ * so threads only share a cell once there are more of them than cells, and then the atomic add still keeps the count exact.
+ * Reading sums up all cells, which is only done when the metrics are scraped.
+ */
+class shardedCounter {
+public:
+  static const unsigned int shardCount = 32;
+
+private:
+  struct alignas(64) cell {
+    std::atomic<uint64_t> value{0};
+  };
+
+  cell cells[shardCount];
+
+  static unsigned int threadShard();
+
+public:
+  shardedCounter();
+
+  shardedCounter(const shardedCounter&) = delete;
+  shardedCounter& operator=(const shardedCounter&) = delete;
+
+  void add(uint64_t value);
+
+  /**
+   * @brief The sum of all cells
+   */
+  uint64_t sum() const;
+
+  /**
+   * @brief Replace the count. Additions running at the same time may or may not be part of the new count.
+   */
+  void store(uint64_t value);
+};
+
+} // namespace metrics
+
+} // namespace kleins
+
+#endif
+ 
+#ifndef COUNTERMETRIC_H
+#define COUNTERMETRIC_H
+
+#include <cassert>
+#include <cinttypes>
+#include <stdio.h>
+
+#ifndef SINGLE_HEADER
+#include "../metricBase/metricBase.h"
+#include "../shardedCounter/shardedCounter.h"
+#endif
+
+namespace kleins {
+
+namespace metrics {
+
+class counterMetric : public metricBase {
+private:
+  // Counted from every connection thread, so it's split over cells that are summed when scraped
+  shardedCounter counterValue;
+
+public:
+  counterMetric(const char* name, const char* help);
+  ~counterMetric();
+
+  uint64_t get();
+  void set(uint64_t value);
+  void inc(uint64_t value = 1);
+  void reset();
+
+  virtual const char* getType();
+
+  virtual std::unique_ptr<char*> construct();
+};
+
+} // namespace metrics
+
+} // namespace kleins
+
+#endif 
+#ifndef HISTOGRAMMETRIC_H
+#define HISTOGRAMMETRIC_H
+
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+
+#ifndef SINGLE_HEADER
+#include "../metricBase/metricBase.h"
+#include "../shardedCounter/shardedCounter.h"
+#endif
+
+namespace kleins {
+
+namespace metrics {
+
+class counterBucketMetricData {
+private:
+  shardedCounter counterValue;
+
+public:
+  uint64_t get();
+  void set(uint64_t value);
+  void inc(uint64_t value = 1);
+  void reset();
+};
+
+class histogramMetric : public metricBase {
+private:
+  std::map<std::string, counterBucketMetricData*> counterValues;
+
+public:
+  histogramMetric(const char* name, const char* help);
+  ~histogramMetric();
+
+  counterBucketMetricData* operator[](std::string& input);
+  counterBucketMetricData* operator[](const char* input);
+
+  void addBucket(const char* bucketName);
+
+  virtual const char* getType();
+
+  virtual std::unique_ptr<char*> construct();
+};
+
+} // namespace metrics
+
+} // namespace kleins
+
+#endif 
+#ifndef GAUGEMETRIC_H
+#define GAUGEMETRIC_H
+
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <stdio.h>
+
+#ifndef SINGLE_HEADER
+#include "../metricBase/metricBase.h"
+#endif
+
+namespace kleins {
+
+namespace metrics {
+
+class gaugeMetric : public metricBase {
+private:
+  // Set from any thread. A gauge is overwritten rather than added to, so there is nothing to sum up and it stays a single value,
+  // on a cache line of its own so setting it doesn't disturb whatever is allocated next to the metric.
+  alignas(64) std::atomic<uint64_t> counterValue{0};
+
+public:
+  gaugeMetric(const char* name, const char* help);
+  ~gaugeMetric();
+
+  uint64_t get();
+  void set(uint64_t value);
+
+  virtual const char* getType();
+
+  virtual std::unique_ptr<char*> construct();
+};
+
+} // namespace metrics
+
+} // namespace kleins
+
+#endif 
+#ifndef SINGLE_HEADER
+#include "httpParser/httpParser.h"
+#include "httpServer/httpServer.h"
+#endif
+
+template <class T> kleins::sessionBase* kleins::httpParser::startSession() {
+  kleins::sessionBase* sb;
+  std::string_view cookie = getHeader("Cookie");
+  if (cookie.length() > 19) {
+    cookie.remove_prefix(19);
+  }
+  // Asked again during the same request, the session it already started is the one meant
+  if (session) {
+    return session;
+  }
+
+  sb = server->startSession<T>(cookie);
+  sessionKey = sb->sessionKey;
+  session = sb;
+  return sb;
+}
+
+template <class T> kleins::sessionPool<T>* kleins::httpServer::getSessionPool() {
+  std::lock_guard<std::mutex> lock(sessionPoolMutex);
+
+  std::unique_ptr<sessionPoolBase>& pool = sessionPools[std::type_index(typeid(T))];
+  if (!pool) {
+    pool.reset(new sessionPool<T>());
+  }
+
+  return static_cast<sessionPool<T>*>(pool.get());
+}
+
+template <class T> kleins::sessionBase* kleins::httpServer::startSession(std::string_view authKey) {
+  sessionBase* existing = sessions.find(authKey);
+  if (existing) {
+    return existing;
+  }
+
+  sessionSnapshot* saved = snapshot.load(std::memory_order_acquire);
+  sessionSnapshot::record restored;
+
+  // A session from before the restart, restored the first time it's used
+  if (saved && saved->take(authKey, restored)) {
+    T* sb = getSessionPool<T>()->create();
+
+    if (sb->deserialize(restored.data)) {
+      sb->setExpireTime(restored.expireTime);
+
+      if (sessions.add(sb, authKey)) {
+        if (metric_activeSessions) {
+          metric_activeSessions->set(sessions.size());
+        }
+
+        return sb;
+      }
+    }
+
+    sessionPoolBase::destroy(sb);
+  }
+
+  T* sb = getSessionPool<T>()->create();
+  sessions.add(sb);
+
+  if (metric_totalSessions) {
+    metric_totalSessions->inc();
+    metric_activeSessions->set(sessions.size());
+  }
+
+  return sb;
+}
+
+template <class table> bool kleins::httpServer::dispatchRouteTable(const void* routes, httpParser* parser) {
+  return ((const table*)routes)->dispatch(parser->method, parser->path, parser);
+}
+
+template <class... handlers> void kleins::httpServer::on(const routeTable<handlers...>& table) {
+  std::lock_guard<std::mutex> lock(routeTableMutex);
+
+  std::shared_ptr<const routeTable<handlers...>> stored = std::make_shared<const routeTable<handlers...>>(table);
+  routeTableStorage.push_back(stored);
+
+  std::vector<compiledRouteTable> tables;
+  tables.push_back({stored.get(), &dispatchRouteTable<routeTable<handlers...>>});
+
+  const std::vector<compiledRouteTable>* previous = compiledRoutes.load(std::memory_order_acquire);
+  if (previous) {
+    tables.insert(tables.end(), previous->begin(), previous->end());
+  }
+
+  routeTables.push_back(std::move(tables));
+  compiledRoutes.store(&routeTables.back(), std::memory_order_release);
+}
+ 
+#ifndef URINGCONNECTION_H
+#define URINGCONNECTION_H
+
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#include "../packet/packet.h"
+#endif
+
+namespace kleins {
+class uringSocket;
+
+/**
+ * @brief A connection whose I/O is done through the io_uring of the uringSocket that accepted it.
+ *
+ * Reads arrive as completions on the socket's ring, writes are queued on it and go out with the next submission.
+ */
+class uringConnection : public connectionBase {
+  friend class uringSocket;
+
+private:
+  int connectionfd;
+  uringSocket* socket;
+
+  // Output waits in pendingOutput until the send in flight completed, one chunk is sent at a time.
+  // Bytes are sent from sendBuffer and shared memory from sendMemory, file ranges are read into sendBuffer piece by piece first.
+  // Whatever is sent has to stay put until the kernel is done with it.
+  std::string sendBuffer;
+  std::shared_ptr<const char> sendMemory;
+  const char* sendStart = 0;
+  size_t sendLength = 0;
+  size_t sendOffset = 0;
+
+  // Whether a send or a read of a file piece is in flight
+  bool sending = false;
+
+  // Operations on the ring that still reference this connection. It can only be deleted once this drops to 0.
+  unsigned int pendingOperations = 0;
+
+  void recieved(const char* data, int datalength);
+
+protected:
+  virtual void writeData(const char* data, int datalength);
+  virtual void writeFile(int filefd, off_t offset, size_t length, std::shared_ptr<const void> fileOwner);
+  virtual void writeShared(std::shared_ptr<const char> data, size_t length);
+
+public:
+  uringConnection(int connectionid, uringSocket* owner);
+  ~uringConnection();
+
+  virtual bool getAlive();
+  virtual int getFd();
+  virtual bool usesEventLoop();
+  virtual bool hasPendingOutput();
+  virtual void tick();
+  virtual void flush();
+  virtual void close_socket();
+};
+}; // namespace kleins
+
+#endif
+ 
+#ifndef URINGSOCKET_H
+#define URINGSOCKET_H
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../socketBase/socketBase.h"
+#include "../timerWheel/timerWheel.h"
+#include "../uringConnection/uringConnection.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief A tcp socket that does accept, recv and send for all of its connections through one io_uring.
+ *
+ * Accepts and reads are multishot, reads land in a pool of buffers provided to the kernel up front,
+ * and everything queued while handling a batch of completions goes out with a single io_uring_enter.
+ * Can be used in place of a tcpSocket with httpServer::addSocket.
+ */
+class uringSocket : public socketBase {
+  friend class uringConnection;
+
+private:
+  // Stored in the low bits of the user data of every submission, next to the connection pointer
+  enum uringOperation {
+    URING_OP_ACCEPT = 1,
+    URING_OP_RECV = 2,
+    URING_OP_SEND = 3,
+    URING_OP_SWEEP = 4,
+    URING_OP_PROVIDE = 5,
+    URING_OP_READ = 6,
+  };
+
+  // File ranges are read and sent in pieces of this size, so a large file never sits in memory as a whole
+  static constexpr size_t fileReadSize = 256 * 1024;
+
+  int socketfd = -1;
+  struct sockaddr_in address;
+
+  unsigned int queueDepth;
+  int ringfd = -1;
+
+  // Submission queue, shared with the kernel
+  void* sqRing = MAP_FAILED;
+  size_t sqRingSize;
+  unsigned* sqHead;
+  unsigned* sqTail;
+  unsigned* sqMask;
+  unsigned* sqArray;
+  io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+  size_t sqesSize;
+  unsigned int unsubmitted = 0;
+
+  // Completion queue, shared with the kernel
+  void* cqRing = MAP_FAILED;
+  size_t cqRingSize;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned* cqMask;
+  io_uring_cqe* cqes;
+
+  // Buffers provided to the kernel that multishot recvs pick from, a buffer is handed back once its data was delivered
+  static const unsigned int recvBufferCount = 1024;
+  static const unsigned int recvBufferSize = 4096;
+  static const unsigned short recvBufferGroup = 0;
+  char* recvBuffers = (char*)MAP_FAILED;
+
+  // Completes once a second, so the timeouts are checked even when nothing else happens
+  struct __kernel_timespec sweepInterval = {1, 0};
+
+  // The timeouts of all connections, in milliseconds since the ring was set up. now is read once per batch of completions.
+  std::chrono::time_point<std::chrono::steady_clock> startTime;
+  uint64_t now = 0;
+  timerWheel timeouts;
+
+  std::unordered_set<uringConnection*> connections;
+
+  io_uring_sqe* nextSqe(uint64_t userData);
+  int enter(unsigned int toSubmit, unsigned int minComplete, unsigned int flags);
+
+  void queueAccept();
+  void queueRecv(uringConnection* conn);
+  void queueSend(uringConnection* conn);
+  void queueRead(uringConnection* conn, int filefd, off_t offset, size_t length);
+  void sendNext(uringConnection* conn);
+  void queueSweep();
+  void returnRecvBuffer(unsigned short bufferId);
+
+  void handleCompletion(io_uring_cqe* cqe);
+  void onAccept(io_uring_cqe* cqe);
+  void onRecv(uringConnection* conn, io_uring_cqe* cqe);
+  void onSend(uringConnection* conn, io_uring_cqe* cqe);
+  void onRead(uringConnection* conn, io_uring_cqe* cqe);
+  void onSweep();
+  void closeTimedOut();
+  void releaseIfDone(uringConnection* conn);
+
+  bool setupRing();
+
+  bool tick(unsigned int shard);
+  void interruptTicks();
+
+public:
+  /**
+   * @brief Construct a new io_uring socket
+   *
+   * @param listenAddress The address to listen on
+   * @param listenPort The port to listen on
+   * @param queueDepth The amount of submission queue entries of the ring
+   */
+  uringSocket(const char* listenAddress, const int listenPort, unsigned int queueDepth = 4096);
+  ~uringSocket();
+
+  std::future<bool> init();
+};
+
+}; // namespace kleins
+
+#endif
+ 
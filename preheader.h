@@ -3,15 +3,32 @@
 namespace kleins {
     namespace metrics {
         class metricBase;
+        class shardedCounter;
         class counterMetric;
         class histogramMetric;
         class gaugeMetric;
         class metricServer;
     };
     class packet;
+    class timerWheel;
     class connectionBase;
+    class eventLoop;
+    class workerPool;
+    class responseBuilder;
+    class staticFile;
+    class fileCache;
+    class scanner;
+    class requestArena;
+    class requestReader;
+    class router;
+    class responseWriter;
     class tcpConnection;
+    class uringConnection;
     class httpParser;
     class socketBase;
+    class uringSocket;
     class sessionBase;
+    class sessionPoolBase;
+    class sessionStore;
+    class sessionSnapshot;
 }
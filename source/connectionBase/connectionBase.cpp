@@ -1,44 +1,411 @@
 #include "connectionBase.h"
+#include "../eventLoop/eventLoop.h"
 
 kleins::connectionBase::connectionBase() {
+  timeoutTimer.owner = this;
 }
 
 kleins::connectionBase::~connectionBase() {
-  if (tickThread) {
-    delete tickThread;
+  stopTimeouts();
+
+  closed = true;
+  releaseDrainWaiters();
+}
+
+void kleins::connectionBase::sendData(const char* data, int datalength) {
+  if (loop && !loop->onLoopThread(this)) {
+    std::string copy(data, datalength);
+    loop->post(this, [this, copy]() { writeData(copy.data(), copy.length()); });
+    return;
   }
+
+  writeData(data, datalength);
+}
+
+void kleins::connectionBase::sendFile(int filefd, off_t offset, size_t length, std::shared_ptr<const void> fileOwner) {
+  runOnLoop([this, filefd, offset, length, fileOwner]() { writeFile(filefd, offset, length, fileOwner); });
+}
+
+void kleins::connectionBase::sendShared(std::shared_ptr<const char> data, size_t length) {
+  runOnLoop([this, data, length]() { writeShared(data, length); });
 }
 
-void kleins::connectionBase::startOwnTickLoop() {
-  tickThread = new std::thread(ownTickLoop, this);
+ssize_t kleins::connectionBase::writeSome(const char* /*data*/, size_t /*length*/) {
+  return -1;
 }
 
-void kleins::connectionBase::ownTickLoop(connectionBase* connection) {
-  while (connection->getAlive()) {
-    connection->tick();
-    usleep(2000);
+ssize_t kleins::connectionBase::sendFileSome(int filefd, off_t offset, size_t length) {
+  char buffer[65536];
+
+  ssize_t readBytes = pread(filefd, buffer, std::min(length, sizeof(buffer)), offset);
+  if (readBytes <= 0) {
+    return -1;
+  }
+
+  // Whatever the socket doesn't take is read again on the next attempt
+  return writeSome(buffer, readBytes);
+}
+
+void kleins::connectionBase::writeData(const char* data, int datalength) {
+  if (closed) {
+    return;
+  }
+
+  if (pendingOutput.empty()) {
+    while (datalength > 0) {
+      ssize_t written = writeSome(data, datalength);
+
+      if (written < 0) {
+        close_socket();
+        return;
+      }
+
+      if (written == 0) {
+        break;
+      }
+
+      data += written;
+      datalength -= written;
+      resetTimeoutTimer();
+    }
+  }
+
+  if (datalength <= 0) {
+    return;
+  }
+
+  // The write timeout counts from when output starts waiting
+  if (pendingOutput.empty()) {
+    resetTimeoutTimer();
+  }
+
+  if (pendingOutput.empty() || pendingOutput.back().filefd >= 0 || pendingOutput.back().shared) {
+    pendingOutput.emplace_back();
   }
+
+  outputChunk& chunk = pendingOutput.back();
+  chunk.data.append(data, datalength);
+  chunk.length += datalength;
+
+  pendingBytes += datalength;
 }
 
-void kleins::connectionBase::join() {
-  if (tickThread != 0) {
-    if (tickThread->joinable()) {
-      tickThread->join();
+void kleins::connectionBase::writeFile(int filefd, off_t offset, size_t length, std::shared_ptr<const void> fileOwner) {
+  if (closed) {
+    return;
+  }
+
+  if (pendingOutput.empty()) {
+    while (length > 0) {
+      ssize_t written = sendFileSome(filefd, offset, length);
+
+      if (written < 0) {
+        close_socket();
+        return;
+      }
+
+      if (written == 0) {
+        break;
+      }
+
+      offset += written;
+      length -= written;
+      resetTimeoutTimer();
     }
   }
+
+  if (length == 0) {
+    return;
+  }
+
+  if (pendingOutput.empty()) {
+    resetTimeoutTimer();
+  }
+
+  outputChunk chunk;
+  chunk.filefd = filefd;
+  chunk.offset = offset;
+  chunk.length = length;
+  chunk.fileOwner = std::move(fileOwner);
+  pendingOutput.push_back(std::move(chunk));
+}
+
+void kleins::connectionBase::writeShared(std::shared_ptr<const char> data, size_t length) {
+  if (closed) {
+    return;
+  }
+
+  size_t offset = 0;
+
+  if (pendingOutput.empty()) {
+    while (offset < length) {
+      ssize_t written = writeSome(data.get() + offset, length - offset);
+
+      if (written < 0) {
+        close_socket();
+        return;
+      }
+
+      if (written == 0) {
+        break;
+      }
+
+      offset += written;
+      resetTimeoutTimer();
+    }
+  }
+
+  if (offset == length) {
+    return;
+  }
+
+  if (pendingOutput.empty()) {
+    resetTimeoutTimer();
+  }
+
+  outputChunk chunk;
+  chunk.shared = std::move(data);
+  chunk.offset = offset;
+  chunk.length = length - offset;
+  pendingOutput.push_back(std::move(chunk));
+}
+
+void kleins::connectionBase::flush() {
+  while (!pendingOutput.empty()) {
+    outputChunk& chunk = pendingOutput.front();
+
+    ssize_t written;
+    if (chunk.filefd >= 0) {
+      written = sendFileSome(chunk.filefd, chunk.offset, chunk.length);
+    } else if (chunk.shared) {
+      written = writeSome(chunk.shared.get() + chunk.offset, chunk.length);
+    } else {
+      written = writeSome(chunk.data.data() + chunk.offset, chunk.length);
+    }
+
+    if (written < 0) {
+      close_socket();
+      return;
+    }
+
+    if (written == 0) {
+      return;
+    }
+
+    chunk.offset += written;
+    chunk.length -= written;
+
+    // A client that keeps taking data isn't idle, even when it has nothing to send
+    resetTimeoutTimer();
+
+    if (chunk.filefd < 0 && !chunk.shared) {
+      pendingBytes -= written;
+      releaseDrainWaiters();
+    }
+
+    if (chunk.length == 0) {
+      pendingOutput.pop_front();
+    }
+  }
+
+  if (closeRequested) {
+    close_socket();
+  }
+}
+
+void kleins::connectionBase::waitUntilDrained(size_t maxPendingBytes) {
+  if (!loop || loop->onLoopThread(this)) {
+    return;
+  }
+
+  std::promise<void> drained;
+  std::future<void> drainedFuture = drained.get_future();
+
+  // Queued behind everything this thread sent before, so that data is already accounted for when the check runs
+  loop->post(this, [this, maxPendingBytes, &drained]() {
+    drainWaiters.push_back(std::make_pair(maxPendingBytes, &drained));
+    releaseDrainWaiters();
+  });
+
+  drainedFuture.wait();
+}
+
+void kleins::connectionBase::releaseDrainWaiters() {
+  auto it = drainWaiters.begin();
+  while (it != drainWaiters.end()) {
+    if (closed || pendingBytes <= it->first) {
+      it->second->set_value();
+      it = drainWaiters.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void kleins::connectionBase::closeAfterFlush() {
+  runOnLoop([this]() {
+    closeRequested = true;
+
+    if (!hasPendingOutput()) {
+      close_socket();
+    }
+  });
+}
+
+void kleins::connectionBase::runOnLoop(std::function<void()> task) {
+  if (loop && !loop->onLoopThread(this)) {
+    loop->post(this, std::move(task));
+    return;
+  }
+
+  task();
+}
+
+void kleins::connectionBase::pauseReading() {
+  readingPaused = true;
+}
+
+void kleins::connectionBase::resumeReading() {
+  readingPaused = false;
+
+  // The idle timeout was off while reading was paused, it starts over from here
+  resetTimeoutTimer();
+}
+
+bool kleins::connectionBase::getReadingPaused() {
+  return readingPaused;
+}
+
+void kleins::connectionBase::requestStarted() {
+  requestsInFlight++;
+}
+
+void kleins::connectionBase::requestDone() {
+  requestsInFlight--;
+  resetTimeoutTimer();
+}
+
+bool kleins::connectionBase::hasPendingOutput() {
+  return !pendingOutput.empty();
+}
+
+bool kleins::connectionBase::handshakePending() {
+  return false;
+}
+
+bool kleins::connectionBase::usesEventLoop() {
+  return true;
 }
 
 void kleins::connectionBase::setTimeout(unsigned int timeoutin) {
-  timeout = timeoutin;
+  timeouts.idle = timeoutin;
+}
+
+void kleins::connectionBase::setTimeouts(const connectionTimeouts& connTimeouts) {
+  timeouts = connTimeouts;
+}
+
+const kleins::connectionTimeouts& kleins::connectionBase::getTimeouts() {
+  return timeouts;
+}
+
+void kleins::connectionBase::startTimeouts(timerWheel* wheel, const uint64_t* time) {
+  timeoutWheel = wheel;
+  loopTime = time;
+  lastActivity = *loopTime;
+
+  // A client that never finishes its handshake is held to the same deadline as one that never finishes its request head
+  if (handshakePending()) {
+    setReadDeadline(timeouts.header);
+  }
+
+  uint64_t deadline = getDeadline();
+  if (deadline) {
+    timeoutWheel->schedule(&timeoutTimer, deadline);
+  }
+}
+
+void kleins::connectionBase::stopTimeouts() {
+  if (timeoutWheel) {
+    timeoutWheel->cancel(&timeoutTimer);
+  }
+
+  timeoutWheel = 0;
+}
+
+bool kleins::connectionBase::timeoutFired() {
+  uint64_t deadline = getDeadline();
+
+  if (deadline == 0) {
+    return false;
+  }
+
+  // The connection was active since the timer was scheduled
+  if (deadline > *loopTime) {
+    timeoutWheel->schedule(&timeoutTimer, deadline);
+    return false;
+  }
+
+  return true;
 }
 
 void kleins::connectionBase::resetTimeoutTimer() {
-  lastPacket = std::chrono::steady_clock::now();
+  if (!loopTime) {
+    return;
+  }
+
+  lastActivity = *loopTime;
+
+  // The timer is off while no timeout applies, this turns it back on once one does
+  if (!timeoutTimer.isScheduled() && timeoutWheel) {
+    uint64_t deadline = getDeadline();
+    if (deadline) {
+      timeoutWheel->schedule(&timeoutTimer, deadline);
+    }
+  }
+}
+
+void kleins::connectionBase::setReadDeadline(unsigned int timeoutin) {
+  if (!timeoutWheel || timeoutin == 0) {
+    readDeadline = 0;
+    return;
+  }
+
+  readDeadline = *loopTime + timeoutin;
+
+  // The timer only ever fires early, so it only has to be moved when the deadline comes before it
+  if (!timeoutTimer.isScheduled() || timeoutTimer.deadline > readDeadline) {
+    timeoutWheel->schedule(&timeoutTimer, readDeadline);
+  }
+}
+
+void kleins::connectionBase::clearReadDeadline() {
+  readDeadline = 0;
+}
+
+uint64_t kleins::connectionBase::getDeadline() {
+  unsigned int activityTimeout = timeouts.idle;
+
+  if (hasPendingOutput()) {
+    activityTimeout = timeouts.write;
+  } else if (requestsInFlight > 0 || readingPaused) {
+    // A callback still working on a request isn't idle time, however long it takes
+    activityTimeout = 0;
+  }
+  uint64_t deadline = activityTimeout ? lastActivity + activityTimeout : 0;
+
+  if (readDeadline && (!deadline || readDeadline < deadline)) {
+    deadline = readDeadline;
+  }
+
+  return deadline;
 }
 
 bool kleins::connectionBase::getTimeout() {
-  if (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastPacket).count() > timeout) {
-    return true;
+  if (!loopTime) {
+    return false;
   }
-  return false;
-}
\ No newline at end of file
+
+  uint64_t deadline = getDeadline();
+  return deadline && deadline <= *loopTime;
+}
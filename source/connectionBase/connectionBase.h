@@ -2,47 +2,283 @@
 #define CONNECTIONBASE_H
 
 #include <chrono>
+#include <deque>
+#include <functional>
 #include <future>
 #include <iostream>
 #include <list>
+#include <memory>
+#include <string>
 #include <sys/socket.h>
 #include <thread>
 #include <unistd.h>
 
 #ifndef SINGLE_HEADER
 #include "../packet/packet.h"
+#include "../timerWheel/timerWheel.h"
 #endif
 
 namespace kleins {
+class eventLoop;
+class connectionBase;
+
+/**
+ * @brief How long a connection may take for each part of an exchange, in milliseconds. 0 disables a timeout.
+ */
+struct connectionTimeouts {
+  /**
+   * @brief How long a connection may go without receiving or sending anything while it isn't in the middle of a request.
+   * It doesn't run while a callback on the worker pool is handling a request of the connection.
+   */
+  unsigned int idle = 30000;
+
+  /**
+   * @brief How long the request line and headers of a request may take to arrive, counted from their first byte
+   */
+  unsigned int header = 10000;
+
+  /**
+   * @brief How long the body of a request may take to arrive, counted from the end of its head. Streamed bodies are only bound by the idle timeout.
+   */
+  unsigned int body = 60000;
+
+  /**
+   * @brief How long the client may go without taking any of the pending output
+   */
+  unsigned int write = 30000;
+};
+
+/**
+ * @brief The timer of a connection on the timer wheel of the thread driving it
+ */
+struct connectionTimer : timerWheel::timer {
+  connectionBase* owner = 0;
+};
+
 class connectionBase {
+  friend class eventLoop;
+
 private:
-  static void ownTickLoop(connectionBase* conn);
-  std::thread* tickThread = 0;
-  unsigned int timeout = 30000;
+  connectionTimeouts timeouts;
+
+  // The timer wheel of the thread driving this connection, and the time of that thread in milliseconds, which it reads once per batch of events.
+  // Activity only stores that time, the timer is moved when it fires early or a read deadline comes before it.
+  connectionTimer timeoutTimer;
+  timerWheel* timeoutWheel = 0;
+  const uint64_t* loopTime = 0;
+
+  uint64_t lastActivity = 0;
+
+  // When the request being read has to be complete, 0 if there is no such deadline
+  uint64_t readDeadline = 0;
+
+  // The eventLoop driving this connection and its per thread state, set by eventLoop::addConnection.
+  eventLoop* loop = 0;
+  void* loopWorker = 0;
+
+  // The epoll events this connection is currently registered for, maintained by the eventLoop.
+  uint32_t watchedEvents = 0;
+
+  bool readingPaused = false;
+
+  // Requests handed off to other threads. The eventLoop keeps the connection alive until all of them came back.
+  unsigned int requestsInFlight = 0;
+  bool orphaned = false;
+
+  // Threads blocked in waitUntilDrained, with the amount of pending bytes each of them waits for
+  std::list<std::pair<size_t, std::promise<void>*>> drainWaiters;
+
+  void releaseDrainWaiters();
+
+protected:
+  // A piece of output that could not be written yet, either bytes, bytes shared with other owners or a range of a file
+  struct outputChunk {
+    std::string data;
+    std::shared_ptr<const char> shared;
+    int filefd = -1;
+    off_t offset = 0;
+    size_t length = 0;
+
+    // Keeps the file of a file chunk open until the chunk was written
+    std::shared_ptr<const void> fileOwner;
+  };
+
+  // Output that could not be written without blocking, flushed in order once the socket becomes writable again.
+  std::deque<outputChunk> pendingOutput;
+
+  // The bytes held in the data chunks of pendingOutput
+  size_t pendingBytes = 0;
+
+  bool closed = false;
+  bool closeRequested = false;
 
-  std::chrono::time_point<std::chrono::steady_clock> lastPacket;
+  /**
+   * @brief Write as much of data as the socket takes without blocking
+   *
+   * @return The amount of bytes written, 0 if the socket would block, -1 on error
+   */
+  virtual ssize_t writeSome(const char* data, size_t length);
+
+  /**
+   * @brief Write as much of a file range as the socket takes without blocking. Reads the file through a buffer unless overridden.
+   *
+   * @return The amount of bytes written, 0 if the socket would block, -1 on error
+   */
+  virtual ssize_t sendFileSome(int filefd, off_t offset, size_t length);
+
+  /**
+   * @brief Write data to the peer. Never blocks, whatever can't be written right away is kept in pendingOutput.
+   * Only called from the thread driving the connection.
+   */
+  virtual void writeData(const char* data, int datalength);
+
+  /**
+   * @brief Like writeData, for a range of a file. fileOwner is held as long as the range is queued.
+   */
+  virtual void writeFile(int filefd, off_t offset, size_t length, std::shared_ptr<const void> fileOwner);
+
+  /**
+   * @brief Like writeData, but whatever can't be written right away is kept by holding on to data instead of copying it
+   */
+  virtual void writeShared(std::shared_ptr<const char> data, size_t length);
 
 public:
   connectionBase();
-  ~connectionBase();
+  virtual ~connectionBase();
 
   virtual bool getAlive() = 0;
 
-  void startOwnTickLoop();
+  /**
+   * @brief The file descriptor the eventLoop should watch for this connection
+   */
+  virtual int getFd() = 0;
 
+  /**
+   * @brief Read everything that is currently available. Called by the eventLoop when the socket is readable.
+   */
   virtual void tick() = 0;
 
-  virtual void sendData(const char* data, int datalength) = 0;
+  /**
+   * @brief Write out pendingOutput. Called by the eventLoop when the socket is writable.
+   */
+  virtual void flush();
+
+  /**
+   * @brief Send data to the peer. Never blocks and may be called from any thread,
+   * calls from outside the eventLoop thread of the connection are forwarded to it.
+   */
+  void sendData(const char* data, int datalength);
+
+  /**
+   * @brief Send length bytes of an open file starting at offset, after everything sent before. Like sendData it may be called from any thread.
+   *
+   * @param filefd The file, it has to stay open until the data is sent
+   * @param fileOwner Whatever keeps the file open, e.g. a staticFile::descriptor. It's held until the data is sent.
+   */
+  void sendFile(int filefd, off_t offset, size_t length, std::shared_ptr<const void> fileOwner = std::shared_ptr<const void>());
+
+  /**
+   * @brief Send length bytes of memory that is shared with other owners, like a mapped file, without copying it.
+   * The memory is held until it was written. Like sendData it may be called from any thread.
+   */
+  void sendShared(std::shared_ptr<const char> data, size_t length);
 
   virtual void close_socket() = 0;
 
-  void join();
+  /**
+   * @brief Close the socket as soon as all pending output has been written. May be called from any thread.
+   */
+  void closeAfterFlush();
+
+  /**
+   * @brief Block until no more than maxPendingBytes of sent data are waiting to be written, or the connection is closed.
+   * Returns right away on the thread driving the connection, which can't wait for itself.
+   */
+  void waitUntilDrained(size_t maxPendingBytes);
+
+  /**
+   * @brief Run task on the thread that drives this connection, right away if this is already that thread.
+   * Tasks of one connection run in the order they were posted.
+   */
+  void runOnLoop(std::function<void()> task);
+
+  /**
+   * @brief Stop or resume reading from the socket. Only call these from the thread driving the connection.
+   */
+  void pauseReading();
+  void resumeReading();
+  bool getReadingPaused();
+
+  /**
+   * @brief Mark a request as handed off to another thread. The connection won't be deleted until requestDone() was called for it.
+   * Only call these from the thread driving the connection.
+   */
+  void requestStarted();
+  void requestDone();
 
+  virtual bool hasPendingOutput();
+
+  /**
+   * @brief Whether the connection still has to finish a handshake before it carries requests. It has to be done within the header timeout.
+   */
+  virtual bool handshakePending();
+
+  /**
+   * @brief Whether this connection should be handed to the eventLoop. Backends that drive their own I/O return false.
+   */
+  virtual bool usesEventLoop();
+
+  /**
+   * @brief Set the idle timeout
+   */
   void setTimeout(unsigned int timeoutInMS = 30000);
 
+  void setTimeouts(const connectionTimeouts& connTimeouts);
+
+  /**
+   * @brief Put the connection on the timer wheel of the thread driving it. Only call this and the following from that thread.
+   *
+   * @param wheel The timer wheel, counting milliseconds
+   * @param time The current time of the wheel's thread, it has to stay valid until stopTimeouts
+   */
+  void startTimeouts(timerWheel* wheel, const uint64_t* time);
+
+  /**
+   * @brief Take the connection off its timer wheel
+   */
+  void stopTimeouts();
+
+  /**
+   * @brief Called when the timer of the connection fired. Puts the timer back if the connection has time left.
+   *
+   * @return Whether the connection timed out and has to be closed
+   */
+  bool timeoutFired();
+
+  /**
+   * @brief Mark the connection as active. Doesn't read the clock, it takes the time its thread read for the current batch of events.
+   */
   void resetTimeoutTimer();
+
+  /**
+   * @brief Require the request being read to be complete within timeoutInMS. Replaces the previous read deadline.
+   */
+  void setReadDeadline(unsigned int timeoutInMS);
+  void clearReadDeadline();
+
+  /**
+   * @brief When the connection times out, in the time of its timer wheel. 0 if it never does.
+   */
+  uint64_t getDeadline();
   bool getTimeout();
 
+  const connectionTimeouts& getTimeouts();
+
+  /**
+   * @brief The listener shard that accepted this connection, the eventLoop keeps it on the matching thread. -1 if the listener isn't sharded.
+   */
+  int shard = -1;
+
   std::function<void(std::unique_ptr<packet>)> onRecieveCallback;
 };
 } // namespace kleins
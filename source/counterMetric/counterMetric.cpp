@@ -15,25 +15,25 @@ const char* kleins::metrics::counterMetric::getType() {
 std::unique_ptr<char*> kleins::metrics::counterMetric::construct() {
   char* targetBuffer = new char[4096];
 
-  snprintf(targetBuffer, 4096, "# HELP %s %s\n# TYPE %s %s\n%s %i\n", nameString, helpString, nameString, getType(), nameString, counterValue);
+  snprintf(targetBuffer, 4096, "# HELP %s %s\n# TYPE %s %s\n%s %" PRIu64 "\n", nameString, helpString, nameString, getType(), nameString, get());
 
   return std::make_unique<char*>(targetBuffer);
 };
 
 uint64_t kleins::metrics::counterMetric::get() {
-  return counterValue;
+  return counterValue.sum();
 }
 
 void kleins::metrics::counterMetric::set(uint64_t value) {
-  assert(("Attemped to decrease counter value", value < counterValue));
+  assert(("Attemped to decrease counter value", value < get()));
 
-  counterValue = value;
+  counterValue.store(value);
 }
 
 void kleins::metrics::counterMetric::inc(uint64_t value) {
-  counterValue += value;
+  counterValue.add(value);
 }
 
 void kleins::metrics::counterMetric::reset() {
-  counterValue = 0;
+  counterValue.store(0);
 }
\ No newline at end of file
@@ -2,10 +2,12 @@
 #define COUNTERMETRIC_H
 
 #include <cassert>
+#include <cinttypes>
 #include <stdio.h>
 
 #ifndef SINGLE_HEADER
 #include "../metricBase/metricBase.h"
+#include "../shardedCounter/shardedCounter.h"
 #endif
 
 namespace kleins {
@@ -14,7 +16,8 @@ namespace metrics {
 
 class counterMetric : public metricBase {
 private:
-  uint64_t counterValue = 0;
+  // Counted from every connection thread, so it's split over cells that are summed when scraped
+  shardedCounter counterValue;
 
 public:
   counterMetric(const char* name, const char* help);
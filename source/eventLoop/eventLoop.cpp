@@ -0,0 +1,315 @@
+#include "eventLoop.h"
+
+kleins::eventLoop::eventLoop(unsigned int threadCount) {
+  startTime = std::chrono::steady_clock::now();
+
+  if (threadCount == 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (unsigned int i = 0; i < threadCount; i++) {
+    worker* w = new worker;
+
+    w->epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (w->epollfd < 0) {
+      std::cerr << "Error creating epoll instance" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    w->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    // The wakefd is the only entry without a connection attached
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = 0;
+    if (w->wakefd < 0 || epoll_ctl(w->epollfd, EPOLL_CTL_ADD, w->wakefd, &event) < 0) {
+      std::cerr << "Error creating eventfd" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    workers.push_back(std::unique_ptr<worker>(w));
+  }
+
+  for (auto& w : workers) {
+    w->thread = new std::thread(workerLoop, this, w.get());
+    w->threadId = w->thread->get_id();
+  }
+}
+
+kleins::eventLoop::~eventLoop() {
+  stop();
+
+  for (auto& w : workers) {
+    for (auto conn : w->connections) {
+      delete conn;
+    }
+
+    close(w->wakefd);
+    close(w->epollfd);
+  }
+}
+
+void kleins::eventLoop::stop() {
+  keepRunning = false;
+
+  for (auto& w : workers) {
+    if (!w->thread) {
+      continue;
+    }
+
+    // Wake the thread up instead of waiting for its epoll_wait to time out
+    uint64_t one = 1;
+    write(w->wakefd, &one, sizeof(one));
+
+    w->thread->join();
+    delete w->thread;
+    w->thread = 0;
+  }
+
+  std::lock_guard<std::recursive_mutex> stoppedLock(stoppedTasksMutex);
+
+  for (auto& w : workers) {
+    std::vector<std::pair<connectionBase*, std::function<void()>>> tasks;
+    {
+      std::lock_guard<std::mutex> lock(w->tasksMutex);
+      if (w->stopped) {
+        continue;
+      }
+
+      w->stopped = true;
+      tasks.swap(w->tasks);
+    }
+
+    // Nothing is written anymore, so threads waiting for output to drain would wait forever
+    for (auto conn : w->connections) {
+      conn->close_socket();
+      conn->releaseDrainWaiters();
+    }
+
+    for (auto& task : tasks) {
+      runStoppedTask(task.first, task.second);
+    }
+  }
+}
+
+void kleins::eventLoop::runStoppedTask(connectionBase* conn, std::function<void()>& task) {
+  task();
+
+  // Closed while a request was out, the last task for it gets to delete the connection
+  if (conn->orphaned && conn->requestsInFlight == 0) {
+    delete conn;
+  }
+}
+
+void kleins::eventLoop::addConnection(connectionBase* conn) {
+  unsigned int index = conn->shard >= 0 ? conn->shard : nextWorker++;
+  worker* w = workers[index % workers.size()].get();
+
+  conn->loop = this;
+  conn->loopWorker = w;
+
+  // Insert before registering, the worker may see events for the connection right away
+  {
+    std::lock_guard<std::mutex> lock(w->connectionsMutex);
+    w->connections.insert(conn);
+    w->arriving.push_back(conn);
+  }
+
+  epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = conn;
+  conn->watchedEvents = event.events;
+
+  if (epoll_ctl(w->epollfd, EPOLL_CTL_ADD, conn->getFd(), &event) < 0) {
+    std::cerr << "Error adding connection to epoll" << std::endl;
+    removeConnection(w, conn);
+  }
+}
+
+void kleins::eventLoop::post(connectionBase* conn, std::function<void()> task) {
+  worker* w = (worker*)conn->loopWorker;
+
+  bool wasEmpty;
+  bool stopped;
+  {
+    std::lock_guard<std::mutex> lock(w->tasksMutex);
+    stopped = w->stopped;
+
+    if (!stopped) {
+      wasEmpty = w->tasks.empty();
+      w->tasks.push_back(std::make_pair(conn, std::move(task)));
+    }
+  }
+
+  if (stopped) {
+    std::lock_guard<std::recursive_mutex> stoppedLock(stoppedTasksMutex);
+    runStoppedTask(conn, task);
+    return;
+  }
+
+  // If there already were tasks the worker has been woken up and hasn't taken them yet
+  if (wasEmpty) {
+    uint64_t one = 1;
+    write(w->wakefd, &one, sizeof(one));
+  }
+}
+
+bool kleins::eventLoop::onLoopThread(connectionBase* conn) {
+  return ((worker*)conn->loopWorker)->threadId == std::this_thread::get_id();
+}
+
+void kleins::eventLoop::workerLoop(eventLoop* loop, worker* w) {
+  const int maxEvents = 256;
+  epoll_event events[maxEvents];
+
+  while (loop->keepRunning) {
+    int eventCount = epoll_wait(w->epollfd, events, maxEvents, 1000);
+    bool woken = false;
+
+    w->now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loop->startTime).count();
+    loop->startTimeouts(w);
+
+    for (int i = 0; i < eventCount; i++) {
+      if (events[i].data.ptr == 0) {
+        woken = true;
+        continue;
+      }
+
+      loop->handleEvents(w, (connectionBase*)events[i].data.ptr, events[i].events);
+    }
+
+    // Posted tasks may delete connections, so only run them once no event of this batch refers to one anymore
+    if (woken) {
+      loop->runTasks(w);
+    }
+
+    // After the batch, so closing a connection can't leave an event of it behind
+    loop->closeTimedOut(w);
+  }
+}
+
+void kleins::eventLoop::handleEvents(worker* w, connectionBase* conn, uint32_t events) {
+  if (events & EPOLLIN) {
+    conn->tick();
+  }
+
+  if ((events & EPOLLOUT) && conn->getAlive()) {
+    conn->flush();
+  }
+
+  if (events & (EPOLLERR | EPOLLHUP)) {
+    conn->close_socket();
+  }
+
+  if (!conn->getAlive()) {
+    removeConnection(w, conn);
+    return;
+  }
+
+  updateWatchedEvents(w, conn);
+}
+
+void kleins::eventLoop::runTasks(worker* w) {
+  uint64_t count;
+  read(w->wakefd, &count, sizeof(count));
+
+  std::vector<std::pair<connectionBase*, std::function<void()>>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(w->tasksMutex);
+    tasks.swap(w->tasks);
+  }
+
+  for (auto& task : tasks) {
+    connectionBase* conn = task.first;
+    task.second();
+
+    // Closed while a request was out, the last task for it gets to delete the connection
+    if (conn->orphaned) {
+      if (conn->requestsInFlight == 0) {
+        delete conn;
+      }
+      continue;
+    }
+
+    if (!conn->getAlive()) {
+      removeConnection(w, conn);
+      continue;
+    }
+
+    updateWatchedEvents(w, conn);
+  }
+}
+
+void kleins::eventLoop::updateWatchedEvents(worker* w, connectionBase* conn) {
+  uint32_t wanted = EPOLLIN;
+  if (conn->hasPendingOutput()) {
+    wanted |= EPOLLOUT;
+  }
+
+  // A connection that is only waiting to finish writing, or whose request is still being handled, shouldn't be read from
+  if (conn->closeRequested || conn->readingPaused) {
+    wanted &= ~EPOLLIN;
+  }
+
+  if (wanted == conn->watchedEvents) {
+    return;
+  }
+
+  epoll_event event;
+  event.events = wanted;
+  event.data.ptr = conn;
+  conn->watchedEvents = wanted;
+
+  epoll_ctl(w->epollfd, EPOLL_CTL_MOD, conn->getFd(), &event);
+}
+
+void kleins::eventLoop::removeConnection(worker* w, connectionBase* conn) {
+  {
+    std::lock_guard<std::mutex> lock(w->connectionsMutex);
+    w->connections.erase(conn);
+
+    if (!w->arriving.empty()) {
+      w->arriving.erase(std::remove(w->arriving.begin(), w->arriving.end(), conn), w->arriving.end());
+    }
+  }
+
+  conn->stopTimeouts();
+
+  // Closing the fd drops it from the epoll set, close_socket is idempotent
+  conn->close_socket();
+  conn->releaseDrainWaiters();
+
+  if (conn->requestsInFlight > 0) {
+    conn->orphaned = true;
+    return;
+  }
+
+  delete conn;
+}
+
+void kleins::eventLoop::startTimeouts(worker* w) {
+  std::vector<connectionBase*> arrived;
+
+  {
+    std::lock_guard<std::mutex> lock(w->connectionsMutex);
+    if (w->arriving.empty()) {
+      return;
+    }
+
+    arrived.swap(w->arriving);
+  }
+
+  for (auto conn : arrived) {
+    conn->startTimeouts(&w->timeouts, &w->now);
+  }
+}
+
+void kleins::eventLoop::closeTimedOut(worker* w) {
+  w->timeouts.advance(w->now, [this, w](timerWheel::timer* fired) {
+    connectionBase* conn = static_cast<connectionTimer*>(fired)->owner;
+
+    if (conn->timeoutFired()) {
+      removeConnection(w, conn);
+    }
+  });
+}
@@ -0,0 +1,119 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#include "../timerWheel/timerWheel.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief An epoll reactor that drives all connections of a server from a fixed set of threads.
+ *
+ * Every thread owns its own epoll instance and the connections assigned to it, so a connection is only ever ticked from one thread.
+ * A thread only wakes up when one of its sockets becomes readable or writable, work was posted to it, or once per second to check its timeouts.
+ * The timeouts of all connections of a thread are on one timer wheel, which the thread advances after every batch of events,
+ * so only connections that are due are ever looked at and the clock is read once per batch instead of on every read or write.
+ */
+class eventLoop {
+private:
+  struct worker {
+    int epollfd;
+    std::thread* thread = 0;
+    std::thread::id threadId;
+
+    // Guards connections and arriving, new connections get added from the accepting thread
+    std::mutex connectionsMutex;
+    std::unordered_set<connectionBase*> connections;
+
+    // Connections added since the thread last looked, their timeouts are started on the thread itself
+    std::vector<connectionBase*> arriving;
+
+    // Milliseconds since the loop started, read once per batch of events. Ticks of the timer wheel are milliseconds as well.
+    uint64_t now = 0;
+    timerWheel timeouts;
+
+    // Work posted from other threads, wakefd is signaled whenever something gets added
+    int wakefd;
+    std::mutex tasksMutex;
+    std::vector<std::pair<connectionBase*, std::function<void()>>> tasks;
+
+    // Set under tasksMutex once the thread was stopped, posted work runs on the posting thread from then on
+    bool stopped = false;
+  };
+
+  std::vector<std::unique_ptr<worker>> workers;
+  std::atomic<unsigned int> nextWorker{0};
+  std::atomic<bool> keepRunning{true};
+
+  std::chrono::time_point<std::chrono::steady_clock> startTime;
+
+  // Serializes the work posted after stop, which may post again while it runs
+  std::recursive_mutex stoppedTasksMutex;
+
+  static void workerLoop(eventLoop* loop, worker* w);
+
+  void handleEvents(worker* w, connectionBase* conn, uint32_t events);
+  void updateWatchedEvents(worker* w, connectionBase* conn);
+  void removeConnection(worker* w, connectionBase* conn);
+  void startTimeouts(worker* w);
+  void closeTimedOut(worker* w);
+  void runTasks(worker* w);
+  void runStoppedTask(connectionBase* conn, std::function<void()>& task);
+
+public:
+  /**
+   * @brief Start the event loop
+   *
+   * @param threadCount The amount of threads to serve connections from. 0 uses one per core.
+   */
+  eventLoop(unsigned int threadCount = 0);
+
+  /**
+   * @brief Stop all threads and close every connection that is still open
+   */
+  ~eventLoop();
+
+  /**
+   * @brief Stop all threads, leaving the connections to the destructor. Lets an owner wait for work that still refers to the connections
+   * before they are deleted.
+   *
+   * The connections are closed, which releases every thread in waitUntilDrained. Work that was posted and work posted from now on
+   * runs on the thread that stops the loop or posts it, one task at a time.
+   */
+  void stop();
+
+  /**
+   * @brief Hand a connection over to the event loop
+   *
+   * @param conn The connection. The event loop takes ownership and deletes it once it is closed.
+   */
+  void addConnection(connectionBase* conn);
+
+  /**
+   * @brief Queue task to run on the thread that drives conn and wake that thread up
+   */
+  void post(connectionBase* conn, std::function<void()> task);
+
+  /**
+   * @brief Whether the calling thread is the one driving conn
+   */
+  bool onLoopThread(connectionBase* conn);
+};
+
+} // namespace kleins
+
+#endif
@@ -0,0 +1,103 @@
+#include "fileCache.h"
+
+kleins::fileCache::fileCache(size_t budgetBytes, size_t maxFileSizeBytes) {
+  budget = budgetBytes;
+  maxFileSize = maxFileSizeBytes;
+
+  metric_hits = new metrics::counterMetric("filecache_hits", "The total ammount of static file requests served from the file cache");
+  metric_misses = new metrics::counterMetric("filecache_misses", "The total ammount of static file requests that had to map the file first");
+  metric_residentBytes = new metrics::gaugeMetric("filecache_resident_bytes", "The ammount of bytes currently mapped by the file cache");
+}
+
+kleins::fileCache::~fileCache() {
+  recentlyUsed.clear();
+  entries.clear();
+
+  delete metric_hits;
+  delete metric_misses;
+  delete metric_residentBytes;
+}
+
+void kleins::fileCache::setLimits(size_t budgetBytes, size_t maxFileSizeBytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  budget = budgetBytes;
+  maxFileSize = maxFileSizeBytes;
+
+  auto it = recentlyUsed.begin();
+  while (it != recentlyUsed.end()) {
+    if (it->file->getSize() > maxFileSize) {
+      residentBytes -= it->file->getSize();
+      entries.erase(it->file);
+      it = recentlyUsed.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  evictUntil(budget);
+  metric_residentBytes->set(residentBytes);
+}
+
+void kleins::fileCache::evictUntil(size_t targetBytes) {
+  while (residentBytes > targetBytes && !recentlyUsed.empty()) {
+    entry& coldest = recentlyUsed.back();
+
+    residentBytes -= coldest.file->getSize();
+    entries.erase(coldest.file);
+
+    // The mapping itself goes away once the last response using it is done
+    recentlyUsed.pop_back();
+  }
+}
+
+std::shared_ptr<const char> kleins::fileCache::get(staticFile* file) {
+  size_t size = file->getSize();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (size == 0 || size > maxFileSize || size > budget) {
+      return std::shared_ptr<const char>();
+    }
+
+    auto cached = entries.find(file);
+    if (cached != entries.end()) {
+      recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, cached->second);
+      metric_hits->inc();
+      return cached->second->mapping;
+    }
+  }
+
+  metric_misses->inc();
+
+  // Faulting the whole file in takes a while, the other files stay available meanwhile
+  std::shared_ptr<const staticFile::descriptor> opened = file->openDescriptor();
+  if (!opened) {
+    return std::shared_ptr<const char>();
+  }
+
+  void* data = mmap(0, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, opened->fd, 0);
+  if (data == MAP_FAILED) {
+    return std::shared_ptr<const char>();
+  }
+
+  std::shared_ptr<const char> mapping((const char*)data, [size](const char* data) { munmap((void*)data, size); });
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // Another request mapped the file at the same time, that mapping is kept and this one goes away with the response
+  if (entries.count(file) != 0 || size > maxFileSize || size > budget) {
+    return mapping;
+  }
+
+  evictUntil(budget - size);
+
+  recentlyUsed.push_front({file, mapping});
+  entries[file] = recentlyUsed.begin();
+  residentBytes += size;
+
+  metric_residentBytes->set(residentBytes);
+
+  return mapping;
+}
@@ -0,0 +1,71 @@
+#ifndef FILECACHE_H
+#define FILECACHE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sys/mman.h>
+#include <unordered_map>
+
+#ifndef SINGLE_HEADER
+#include "../counterMetric/counterMetric.h"
+#include "../gaugeMetric/gaugeMetric.h"
+#include "../staticFile/staticFile.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief Keeps the contents of frequently served static files mapped into memory.
+ *
+ * Files are mapped the first time they are requested and stay resident while they fit into the memory budget,
+ * the least recently used ones are unmapped to make room for new ones. Files bigger than the per file limit are never mapped,
+ * those are better off being sent straight from the file.
+ */
+class fileCache {
+private:
+  struct entry {
+    staticFile* file;
+    std::shared_ptr<const char> mapping;
+  };
+
+  std::mutex mutex;
+
+  // Most recently used first
+  std::list<entry> recentlyUsed;
+  std::unordered_map<staticFile*, std::list<entry>::iterator> entries;
+
+  size_t budget;
+  size_t maxFileSize;
+  size_t residentBytes = 0;
+
+  void evictUntil(size_t targetBytes);
+
+public:
+  /**
+   * @param budgetBytes The amount of bytes that may be mapped at once. 0 disables the cache.
+   * @param maxFileSizeBytes Files bigger than this are never cached
+   */
+  fileCache(size_t budgetBytes, size_t maxFileSizeBytes);
+  ~fileCache();
+
+  /**
+   * @brief Change the limits, files that don't fit anymore are unmapped right away
+   */
+  void setLimits(size_t budgetBytes, size_t maxFileSizeBytes);
+
+  /**
+   * @brief Get the mapped contents of a file, mapping it if it isn't cached yet
+   *
+   * @return The contents of the file, they stay mapped as long as the pointer is held even if the file gets evicted meanwhile.
+   * Empty if the file can't be cached.
+   */
+  std::shared_ptr<const char> get(staticFile* file);
+
+  metrics::counterMetric* metric_hits;
+  metrics::counterMetric* metric_misses;
+  metrics::gaugeMetric* metric_residentBytes;
+};
+}; // namespace kleins
+
+#endif
@@ -15,15 +15,15 @@ const char* kleins::metrics::gaugeMetric::getType() {
 std::unique_ptr<char*> kleins::metrics::gaugeMetric::construct() {
   char* targetBuffer = new char[4096];
 
-  snprintf(targetBuffer, 4096, "# HELP %s %s\n# TYPE %s %s\n%s %i\n", nameString, helpString, nameString, getType(), nameString, counterValue);
+  snprintf(targetBuffer, 4096, "# HELP %s %s\n# TYPE %s %s\n%s %" PRIu64 "\n", nameString, helpString, nameString, getType(), nameString, get());
 
   return std::make_unique<char*>(targetBuffer);
 };
 
 uint64_t kleins::metrics::gaugeMetric::get() {
-  return counterValue;
+  return counterValue.load(std::memory_order_relaxed);
 }
 
 void kleins::metrics::gaugeMetric::set(uint64_t value) {
-  counterValue = value;
+  counterValue.store(value, std::memory_order_relaxed);
 }
\ No newline at end of file
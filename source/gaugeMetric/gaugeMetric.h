@@ -1,7 +1,9 @@
 #ifndef GAUGEMETRIC_H
 #define GAUGEMETRIC_H
 
+#include <atomic>
 #include <cassert>
+#include <cinttypes>
 #include <stdio.h>
 
 #ifndef SINGLE_HEADER
@@ -14,7 +16,9 @@ namespace metrics {
 
 class gaugeMetric : public metricBase {
 private:
-  uint64_t counterValue = 0;
+  // Set from any thread. A gauge is overwritten rather than added to, so there is nothing to sum up and it stays a single value,
+  // on a cache line of its own so setting it doesn't disturb whatever is allocated next to the metric.
+  alignas(64) std::atomic<uint64_t> counterValue{0};
 
 public:
   gaugeMetric(const char* name, const char* help);
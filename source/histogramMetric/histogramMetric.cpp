@@ -1,21 +1,21 @@
 #include "histogramMetric.h"
 
 uint64_t kleins::metrics::counterBucketMetricData::get() {
-  return counterValue;
+  return counterValue.sum();
 }
 
 void kleins::metrics::counterBucketMetricData::set(uint64_t value) {
-  assert(("Attemped to decrease counter value", value < counterValue));
+  assert(("Attemped to decrease counter value", value < get()));
 
-  counterValue = value;
+  counterValue.store(value);
 }
 
 void kleins::metrics::counterBucketMetricData::inc(uint64_t value) {
-  counterValue += value;
+  counterValue.add(value);
 }
 
 void kleins::metrics::counterBucketMetricData::reset() {
-  counterValue = 0;
+  counterValue.store(0);
 }
 
 kleins::metrics::histogramMetric::histogramMetric(const char* name, const char* help) {
@@ -24,6 +24,9 @@ kleins::metrics::histogramMetric::histogramMetric(const char* name, const char*
 }
 
 kleins::metrics::histogramMetric::~histogramMetric() {
+  for (auto& bucket : counterValues) {
+    delete bucket.second;
+  }
 }
 
 const char* kleins::metrics::histogramMetric::getType() {
@@ -10,6 +10,7 @@
 
 #ifndef SINGLE_HEADER
 #include "../metricBase/metricBase.h"
+#include "../shardedCounter/shardedCounter.h"
 #endif
 
 namespace kleins {
@@ -18,7 +19,7 @@ namespace metrics {
 
 class counterBucketMetricData {
 private:
-  uint64_t counterValue = 0;
+  shardedCounter counterValue;
 
 public:
   uint64_t get();
@@ -1,324 +1,438 @@
 #include "httpParser.h"
 
-kleins::httpParser::httpParser(packet* httpdata, connectionBase* conn, httpServer* srv) {
-  data = httpdata;
+kleins::httpParser::httpParser(std::string_view httpRequest, connectionBase* conn, httpServer* srv, std::pmr::memory_resource* requestMemory)
+    : headerFields(requestMemory), parameterFields(requestMemory) {
+  request = httpRequest;
   connsocket = conn;
   server = srv;
+  memory = requestMemory;
 }
 
 kleins::httpParser::~httpParser() {
+  if (session) {
+    sessionStore::release(session);
+  }
 }
 
-bool kleins::httpParser::parse() {
-  unsigned int nextline = 0;
-
-  for (int i = 0; i < data->data.length(); i++) {
-    if (i + 3 >= data->data.length())
-      return false;
-
-    if (data->data[i] != '\r')
-      continue;
-
-    if (data->data[i + 1] != '\n')
-      continue;
-
-    requestline = data->data.substr(0, i);
-
-    nextline = i + 2;
+bool kleins::httpParser::parseHead() {
+  const char* begin = request.data();
+  const char* end = begin + request.length();
 
-    break;
+  const char* requestlineEnd = scanner::findLineEnd(begin, end);
+  if (!requestlineEnd) {
+    return false;
   }
 
-  for (int i = nextline; i < data->data.length(); i++) {
-    if (i + 3 >= data->data.length())
-      return false;
+  requestline = std::string_view(begin, requestlineEnd - begin);
 
-    if (data->data[i] != '\r')
-      continue;
+  // The header block keeps the line ending of its last line, it's empty if the request has no headers
+  const char* headerBegin = requestlineEnd + 2;
+  const char* headEnd = scanner::findHeadEnd(requestlineEnd, end);
+  if (!headEnd) {
+    return false;
+  }
 
-    if (data->data[i + 1] != '\n')
-      continue;
+  header = std::string_view(headerBegin, std::max(headerBegin, headEnd + 2) - headerBegin);
+  body = std::string_view(headEnd + 4, end - (headEnd + 4));
 
-    if (data->data[i + 2] != '\r')
-      continue;
+  parseRequestline();
+  parseHeaders();
 
-    if (data->data[i + 3] != '\n')
-      continue;
+  if (method == "POST" && equalsIgnoreCase(getHeader("Content-Type"), "application/x-www-form-urlencoded")) {
+    parseURLencodedData(body);
+  }
 
-    header = data->data.substr(nextline, i - nextline);
+  return true;
+}
 
-    nextline = i + 4;
-    break;
+bool kleins::httpParser::parse() {
+  if (!parseHead()) {
+    return false;
   }
 
-  body = data->data.substr(nextline);
+  dispatch();
 
-  parseRequestline();
-  parseHeaders();
+  return true;
+}
 
-  if (method == "POST") {
-    if (headers["content-type"] == "application/x-www-form-urlencoded") {
-      parseURLencodedData(body);
+void kleins::httpParser::dispatch() {
+  const std::vector<httpServer::compiledRouteTable>* compiledRoutes = server ? server->compiledRoutes.load(std::memory_order_acquire) : 0;
+  if (compiledRoutes) {
+    for (const httpServer::compiledRouteTable& routes : *compiledRoutes) {
+      if (routes.dispatch(routes.table, this)) {
+        if (server->metric_totalAcccess) {
+          server->metric_totalAcccess->inc();
+        }
+        return;
+      }
     }
   }
 
-  std::string ref;
-
-  ref = method;
-  ref.append(path);
+  const router::route* matched = matchRoute();
 
-  auto search = functionTable.find(ref);
-  if (search != functionTable.end()) {
-    search->second(this);
+  if (matched) {
+    matched->handler(this);
   } else {
     if (server->metric_notfound) {
       server->metric_notfound->inc();
     }
-    connsocket->sendData(
-        "HTTP/1.0 404\r\ncontent-type:text/html; "
-        "charset=UTF-8\r\nContent-Length: 51\r\n\r\n<html><head></head><body>Not "
-        "found</body></html>\r\n",
-        127);
+    respond(404, "<html><head></head><body>Not found</body></html>\r\n");
   }
+}
 
-  return true;
+const kleins::router::route* kleins::httpParser::matchRoute() {
+  if (!routeLookedUp && server) {
+    server->routes.find(method, path, route);
+    routeLookedUp = true;
+  }
+
+  return route.matched;
 }
 
-void kleins::httpParser::on(const std::string& inmethod, const std::string& inuri, const std::function<void(kleins::httpParser*)> callback) {
-  std::string ref;
-  ref.reserve(inmethod.length() + inuri.length() + 1);
+template <class headerList>
+void kleins::httpParser::writeCommonHeaders(responseBuilder& response, const headerList& responseHeaders) {
+  for (auto& responseHeader : responseHeaders) {
+    response.header(responseHeader);
+  }
 
-  ref = inmethod;
-  ref.append(inuri);
+  writeRequestHeaders(response);
+  response.server();
+}
 
-  functionTable.insert(std::make_pair(ref, callback));
+void kleins::httpParser::writeRequestHeaders(responseBuilder& response) {
+  if (!server->keepAliveHeader.empty() && equalsIgnoreCase(getHeader("Connection"), "keep-alive")) {
+    response.header(server->keepAliveHeader);
+  }
+
+  response.date();
+
+  if (!sessionKey.empty()) {
+    response.append("Set-Cookie: KLEINSHTTP-SESSION=");
+    response.append(sessionKey);
+    response.append("; SameSite=Strict; HttpOnly\r\n");
+  };
 }
 
-void kleins::httpParser::on(const std::string& ref, const std::function<void(kleins::httpParser*)> callback) {
-  functionTable.insert(std::make_pair(ref, callback));
+void kleins::httpParser::sendResponse(responseBuilder& response, const char* body, size_t bodyLength) {
+  // Small bodies go out together with the head, big ones are sent from where they are instead of being copied
+  if (bodyLength <= maxCopiedBodySize) {
+    response.append(body, bodyLength);
+    connsocket->sendData(response.data(), response.length());
+    return;
+  }
+
+  connsocket->sendData(response.data(), response.length());
+  connsocket->sendData(body, bodyLength);
 }
 
 void kleins::httpParser::respond(
-    const std::string& status, const std::list<std::string>& responseHeaders, const std::string& body, const std::string& mimeType) {
-  std::stringstream response;
+    const std::string& status, const std::list<std::string>& responseHeaders, std::string_view body, const std::string& mimeType) {
+  respond(status, responseHeaders, body.data(), body.size(), mimeType);
+}
 
-  response << "HTTP/1.1 " << status << "\r\n";
+void kleins::httpParser::respond(const std::string& status, const std::list<std::string>& responseHeaders, const char* body, size_t bodyLength,
+    const std::string& mimeType) {
+  responseBuilder response(memory, responseHeadSize + (bodyLength <= maxCopiedBodySize ? bodyLength : 0));
 
-  std::list<std::string>::const_iterator it;
-  for (it = responseHeaders.begin(); it != responseHeaders.end(); it++) {
-    response << *it << "\r\n";
-  }
+  response.status(status);
+  writeCommonHeaders(response, responseHeaders);
+  response.contentLength(bodyLength);
+  response.contentType(mimeType);
+  response.endHead();
 
-  if (headers["Connection"] == "keep-alive") {
-    response << "Keep-Alive: timeout=30\r\n";
-  }
+  sendResponse(response, body, bodyLength);
+}
 
-  response << "content-length: " << body.size() << "\r\n"
-           << "Content-Type: " << mimeType << "; charset=utf-8 \r\n"
-           << "Server: kleinsHTTP\r\n";
+void kleins::httpParser::respond(unsigned int status, std::string_view body, std::string_view mimeType, std::initializer_list<std::string_view> responseHeaders) {
+  responseBuilder response(memory, responseHeadSize + (body.length() <= maxCopiedBodySize ? body.length() : 0));
 
-  if (sessionKey) {
-    response << "Set-Cookie: KLEINSHTTP-SESSION=" << *sessionKey << "; SameSite=Strict; HttpOnly\r\n";
-  };
+  response.status(status);
+  writeCommonHeaders(response, responseHeaders);
+  response.contentLength(body.length());
+  response.contentType(mimeType);
+  response.endHead();
 
-  response << "\r\n" << body;
+  sendResponse(response, body.data(), body.length());
+}
+
+void kleins::httpParser::respondSerialized(unsigned int status, std::string_view serialized) {
+  responseBuilder response(memory, responseHeadSize + serialized.length());
 
-  std::string finalTarget;
-  finalTarget = response.str();
+  response.status(status);
+  writeRequestHeaders(response);
+  response.append(serialized);
 
-  connsocket->sendData(finalTarget.c_str(), finalTarget.length());
+  connsocket->sendData(response.data(), response.length());
 }
 
-void kleins::httpParser::parseRequestline() {
-  const int length = requestline.length();
+void kleins::httpParser::respondShared(
+    const std::string& status, const std::list<std::string>& responseHeaders, std::shared_ptr<const char> body, size_t bodyLength, const std::string& mimeType) {
+  responseBuilder response(memory, responseHeadSize);
 
-  char* bufferData = new char[(length + 1) * 3];
+  response.status(status);
+  writeCommonHeaders(response, responseHeaders);
+  response.contentLength(bodyLength);
+  response.contentType(mimeType);
+  response.endHead();
 
-  char* methodBuffer = bufferData;
-  char* pathBuffer = bufferData + ((length + 1) * 1);
-  char* variableBuffer = bufferData + ((length + 1) * 2);
+  connsocket->sendData(response.data(), response.length());
+  connsocket->sendShared(std::move(body), bodyLength);
+}
 
-  memset(bufferData, 0, (length + 1) * 3);
+void kleins::httpParser::respondFile(const std::string& status, const std::list<std::string>& responseHeaders, int filefd, off_t offset, size_t length,
+    const std::string& mimeType, std::shared_ptr<const void> fileOwner) {
+  responseBuilder response(memory, responseHeadSize);
 
-  enum REQUESTLINE_STATES {
-    REUQESTLINE_STATE_METHOD,
-    REUQESTLINE_STATE_PATH,
-    REQUESTLINE_STATE_PARAM,
-    REQUESTLINE_STATE_UNPARSABLE,
-  };
+  response.status(status);
+  writeCommonHeaders(response, responseHeaders);
+  response.contentLength(length);
+  response.contentType(mimeType);
+  response.endHead();
 
-  int requestlineState = REUQESTLINE_STATE_METHOD;
-  int offsetCounter = 0;
-  for (auto x : requestline) {
-    auto storeInBuffer = [x, &offsetCounter](char* b) { b[offsetCounter++] = x; };
+  connsocket->sendData(response.data(), response.length());
+  connsocket->sendFile(filefd, offset, length, std::move(fileOwner));
+}
 
-    switch (requestlineState) {
+std::unique_ptr<kleins::responseWriter> kleins::httpParser::respondChunked(
+    const std::string& status, const std::list<std::string>& responseHeaders, const std::string& mimeType) {
+  bool chunked = requestline.length() >= 8 && requestline.compare(requestline.length() - 8, 8, "HTTP/1.1") == 0;
 
-    case REUQESTLINE_STATE_METHOD:
+  responseBuilder response(memory, responseHeadSize);
 
-      if (x != ' ') {
-        storeInBuffer(methodBuffer);
-      } else {
-        offsetCounter = 0;
-        requestlineState = REUQESTLINE_STATE_PATH;
-      }
+  response.status(status);
+  writeCommonHeaders(response, responseHeaders);
 
-      break;
+  if (chunked) {
+    response.header("Transfer-Encoding: chunked");
+  } else {
+    response.header("Connection: close");
+    closeConnection = true;
+  }
 
-    case REUQESTLINE_STATE_PATH:
+  response.contentType(mimeType);
+  response.endHead();
 
-      if (x != ' ' && x != '?') {
-        storeInBuffer(pathBuffer);
-      } else {
-        offsetCounter = 0;
-        requestlineState = REQUESTLINE_STATE_PARAM;
-      }
+  connsocket->sendData(response.data(), response.length());
 
-      break;
+  return std::unique_ptr<responseWriter>(new responseWriter(connsocket, chunked));
+}
 
-    case REQUESTLINE_STATE_PARAM:
+void kleins::httpParser::respondFileRanges(const std::list<std::string>& responseHeaders, int filefd, size_t fileSize,
+    const std::vector<staticFile::byteRange>& ranges, const std::string& mimeType, std::shared_ptr<const void> fileOwner) {
+  const std::string boundary = "kleinsHTTP-byteranges-boundary";
 
-      if (x != ' ') {
-        storeInBuffer(variableBuffer);
-      } else {
-        offsetCounter = 0;
-        requestlineState = REQUESTLINE_STATE_UNPARSABLE;
-      }
+  std::vector<std::string> partHeads;
+  size_t contentLength = 0;
 
-      break;
-    default:
-      break;
-    }
+  for (auto& range : ranges) {
+    std::string partHead = "\r\n--" + boundary + "\r\n";
+    partHead.append("Content-Type: ").append(mimeType).append("\r\n");
+    partHead.append("Content-Range: bytes ").append(std::to_string(range.offset)).append("-");
+    partHead.append(std::to_string(range.offset + range.length - 1)).append("/").append(std::to_string(fileSize)).append("\r\n\r\n");
+
+    contentLength += partHead.length() + range.length;
+    partHeads.push_back(partHead);
   }
 
-  parseURLencodedData(variableBuffer);
+  const std::string closingDelimiter = "\r\n--" + boundary + "--\r\n";
+  contentLength += closingDelimiter.length();
 
-  method = methodBuffer;
-  path = pathBuffer;
+  responseBuilder response(memory, responseHeadSize);
 
-  delete[] bufferData;
-}
+  response.status(206);
+  writeCommonHeaders(response, responseHeaders);
+  response.contentLength(contentLength);
+  response.header("Content-Type", "multipart/byteranges; boundary=" + boundary);
+  response.endHead();
+
+  connsocket->sendData(response.data(), response.length());
 
-void kleins::httpParser::parseURLencodedData(const char* rawData) {
-  const int length = strlen(rawData);
-  parseURLencodedData(rawData, length);
+  for (size_t i = 0; i < ranges.size(); i++) {
+    connsocket->sendData(partHeads[i].c_str(), partHeads[i].length());
+    connsocket->sendFile(filefd, ranges[i].offset, ranges[i].length, fileOwner);
+  }
+
+  connsocket->sendData(closingDelimiter.c_str(), closingDelimiter.length());
 }
 
-void kleins::httpParser::parseURLencodedData(std::string& rawData) {
-  parseURLencodedData(rawData.c_str(), rawData.length());
+void kleins::httpParser::respondNotModified(const std::list<std::string>& responseHeaders) {
+  responseBuilder response(memory, responseHeadSize);
+
+  response.status(304);
+  writeCommonHeaders(response, responseHeaders);
+  response.endHead();
+
+  connsocket->sendData(response.data(), response.length());
 }
 
-void kleins::httpParser::parseURLencodedData(const char* rawData, const int length) {
-  enum parseState {
-    PARSE_STATE_KEY,
-    PARSE_STATE_VALUE,
-  };
+void kleins::httpParser::parseRequestline() {
+  const char* begin = requestline.data();
+  const char* end = begin + requestline.length();
+
+  const char* methodEnd = (const char*)memchr(begin, ' ', end - begin);
+  if (!methodEnd) {
+    method = requestline;
+    return;
+  }
 
-  int offsetCounter = 0;
-  uint8_t currentState = PARSE_STATE_KEY;
+  method = std::string_view(begin, methodEnd - begin);
 
-  char* buffer = new char[(length + 1) * 2];
-  memset(buffer, 0, (length + 1) * 2);
+  const char* pathBegin = methodEnd + 1;
+  const char* pathEnd = scanner::findEither(pathBegin, end, ' ', '?');
+  if (!pathEnd) {
+    pathEnd = end;
+  }
 
-  char* keyBuffer = buffer;
-  char* valueBuffer = buffer + length + 1;
+  path = std::string_view(pathBegin, pathEnd - pathBegin);
 
-  for (int i = 0; i < length; i++) {
-    switch (currentState) {
+  if (pathEnd != end && *pathEnd == '?') {
+    const char* queryBegin = pathEnd + 1;
+    const char* queryEnd = (const char*)memchr(queryBegin, ' ', end - queryBegin);
 
-    case PARSE_STATE_KEY:
-      if (rawData[i] != '=') {
-        keyBuffer[offsetCounter++] = rawData[i];
-      } else {
-        offsetCounter = 0;
-        currentState = PARSE_STATE_VALUE;
-      }
+    query = std::string_view(queryBegin, (queryEnd ? queryEnd : end) - queryBegin);
+    parseURLencodedData(query);
+  }
+}
 
-      break;
+void kleins::httpParser::parseURLencodedData(std::string_view rawData) {
+  const char* end = rawData.data() + rawData.length();
 
-    case PARSE_STATE_VALUE:
-      if (rawData[i] != '&') {
-        valueBuffer[offsetCounter++] = rawData[i];
-      } else {
-        offsetCounter = 0;
-        currentState = PARSE_STATE_KEY;
+  for (const char* pairBegin = rawData.data(); pairBegin < end;) {
+    const char* pairEnd = (const char*)memchr(pairBegin, '&', end - pairBegin);
+    if (!pairEnd) {
+      pairEnd = end;
+    }
 
-        parameters.insert(std::make_pair(std::string(keyBuffer), std::string(valueBuffer)));
+    // Pairs without a value are skipped
+    const char* separator = (const char*)memchr(pairBegin, '=', pairEnd - pairBegin);
+    if (separator) {
+      parameterFields.add(std::string_view(pairBegin, separator - pairBegin), std::string_view(separator + 1, pairEnd - separator - 1));
+    }
 
-        memset(buffer, 0, (length + 1) * 2);
+    pairBegin = pairEnd + 1;
+  }
+}
+
+void kleins::httpParser::parseHeaders() {
+  const char* lineBegin = header.data();
+  const char* end = lineBegin + header.length();
+
+  while (lineBegin < end) {
+    const char* lineEnd = scanner::findLineEnd(lineBegin, end);
+    if (!lineEnd) {
+      lineEnd = end;
+    }
+
+    // A line without a colon has no name and is skipped
+    const char* colon = scanner::findEither(lineBegin, lineEnd, ':', '\r');
+    if (colon && *colon == ':') {
+      const char* valueBegin = colon + 1;
+      const char* valueEnd = lineEnd;
+
+      while (valueBegin < valueEnd && (*valueBegin == ' ' || *valueBegin == '\t')) {
+        valueBegin++;
       }
 
-      break;
+      while (valueEnd > valueBegin && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+        valueEnd--;
+      }
 
-    default:
-      break;
+      headerFields.add(std::string_view(lineBegin, colon - lineBegin), std::string_view(valueBegin, valueEnd - valueBegin));
     }
-  }
 
-  if (currentState == PARSE_STATE_VALUE) {
-    parameters.insert(std::make_pair(std::string(keyBuffer), std::string(valueBuffer)));
+    lineBegin = lineEnd + 2;
   }
+}
 
-  delete[] buffer;
+kleins::httpParser::fieldList::fieldList(std::pmr::memory_resource* memory) : spilledFields(memory) {
 }
 
-void kleins::httpParser::parseHeaders() {
-  enum parseState {
-    PARSE_STATE_KEY,
-    PARSE_STATE_VALUE,
-  };
+void kleins::httpParser::fieldList::add(std::string_view name, std::string_view value) {
+  if (count < inlineCapacity) {
+    inlineFields[count] = {name, value};
+  } else {
+    spilledFields.push_back({name, value});
+  }
 
-  int length = header.length();
+  count++;
+}
 
-  int offsetCounter = 0;
-  uint8_t currentState = PARSE_STATE_KEY;
+const kleins::httpParser::requestField& kleins::httpParser::fieldList::operator[](size_t index) const {
+  if (index < inlineCapacity) {
+    return inlineFields[index];
+  }
 
-  char* buffer = new char[(length + 1) * 2];
-  memset(buffer, 0, (length + 1) * 2);
+  return spilledFields[index - inlineCapacity];
+}
 
-  char* keyBuffer = buffer;
-  char* valueBuffer = buffer + length + 1;
+std::string_view kleins::httpParser::getHeader(std::string_view name) {
+  for (size_t i = 0; i < headerFields.count; i++) {
+    if (equalsIgnoreCase(headerFields[i].name, name)) {
+      return headerFields[i].value;
+    }
+  }
 
-  bool skipNext = false;
-  for (auto x : header) {
-    if (skipNext) {
-      skipNext = false;
-      continue;
+  return std::string_view();
+}
+
+std::string_view kleins::httpParser::getParameter(std::string_view name) {
+  for (size_t i = 0; i < parameterFields.count; i++) {
+    if (parameterFields[i].name == name) {
+      return parameterFields[i].value;
     }
+  }
 
-    switch (currentState) {
-    case PARSE_STATE_KEY:
+  return std::string_view();
+}
 
-      if (x != ':') {
-        keyBuffer[offsetCounter++] = x;
-      } else {
-        skipNext = true;
-        offsetCounter = 0;
-        currentState = PARSE_STATE_VALUE;
-      }
+std::string_view kleins::httpParser::getRouteParameter(std::string_view name) {
+  for (size_t i = 0; i < route.parameterCount; i++) {
+    if (route.parameterNames[i] == name) {
+      return route.parameterValues[i];
+    }
+  }
 
-      break;
+  return std::string_view();
+}
 
-    case PARSE_STATE_VALUE:
+size_t kleins::httpParser::getHeaderCount() {
+  return headerFields.count;
+}
 
-      if (x != '\x0D') {
-        valueBuffer[offsetCounter++] = x;
-      } else {
-        skipNext = true;
-        offsetCounter = 0;
-        currentState = PARSE_STATE_KEY;
+const kleins::httpParser::requestField& kleins::httpParser::getHeaderField(size_t index) {
+  return headerFields[index];
+}
 
-        headers.insert(std::make_pair(std::string(keyBuffer), std::string(valueBuffer)));
+size_t kleins::httpParser::getParameterCount() {
+  return parameterFields.count;
+}
 
-        memset(buffer, 0, (length + 1) * 2);
-      }
+const kleins::httpParser::requestField& kleins::httpParser::getParameterField(size_t index) {
+  return parameterFields[index];
+}
 
-      break;
+std::map<std::string, std::string>& kleins::httpParser::getHeaders() {
+  if (!headerMapBuilt) {
+    for (size_t i = 0; i < headerFields.count; i++) {
+      headerMap.insert(std::make_pair(std::string(headerFields[i].name), std::string(headerFields[i].value)));
+    }
+    headerMapBuilt = true;
+  }
+
+  return headerMap;
+}
 
-    default:
-      break;
+std::map<std::string, std::string>& kleins::httpParser::getParameters() {
+  if (!parameterMapBuilt) {
+    for (size_t i = 0; i < parameterFields.count; i++) {
+      parameterMap.insert(std::make_pair(std::string(parameterFields[i].name), std::string(parameterFields[i].value)));
     }
+    parameterMapBuilt = true;
   }
 
-  delete[] buffer;
+  return parameterMap;
+}
+
+bool kleins::httpParser::equalsIgnoreCase(std::string_view first, std::string_view second) {
+  return first.length() == second.length() && strncasecmp(first.data(), second.data(), first.length()) == 0;
 }
@@ -3,58 +3,258 @@
 
 #include <iostream>
 #include <map>
+#include <memory_resource>
 #include <regex>
 #include <list>
+#include <string_view>
+#include <strings.h>
+#include <vector>
 
 
 #ifndef SINGLE_HEADER
 #include "../connectionBase/connectionBase.h"
 #include "../httpServer/httpServer.h"
 #include "../packet/packet.h"
+#include "../responseBuilder/responseBuilder.h"
+#include "../responseWriter/responseWriter.h"
+#include "../router/router.h"
+#include "../scanner/scanner.h"
 #include "../sessionBase/sessionBase.h"
+#include "../sessionStore/sessionStore.h"
+#include "../staticFile/staticFile.h"
 #endif
 
 namespace kleins {
 class httpServer;
 
 class httpParser {
+public:
+  /**
+   * @brief A header or parameter of the request. Both parts point into the received request.
+   */
+  struct requestField {
+    std::string_view name;
+    std::string_view value;
+  };
+
 private:
-  packet* data;
+  // The fields of a request in the order they were sent. The first ones are stored inline, only unusually large requests spill onto the heap.
+  struct fieldList {
+    static const size_t inlineCapacity = 32;
+
+    requestField inlineFields[inlineCapacity];
+    std::pmr::vector<requestField> spilledFields;
+    size_t count = 0;
+
+    fieldList(std::pmr::memory_resource* memory);
+
+    void add(std::string_view name, std::string_view value);
+    const requestField& operator[](size_t index) const;
+  };
+
+  std::string_view request;
   connectionBase* connsocket;
+
+  // Where everything the parser needs during the request is allocated from
+  std::pmr::memory_resource* memory;
+
   httpServer* server;
-  std::map<std::string, const std::function<void(httpParser*)>> functionTable;
+
+  router::routeMatch route;
+  bool routeLookedUp = false;
+
+  // The session the endpoint started, held until the parser is destroyed
+  sessionBase* session = 0;
+
+  // What is reserved for a response head, and the biggest body that is copied behind the head to send both at once
+  static const size_t responseHeadSize = 512;
+  static const size_t maxCopiedBodySize = 16 * 1024;
+
+  // The headers every response carries: the ones passed by the endpoint, keep-alive, Date, Server and the session cookie
+  template <class headerList>
+  void writeCommonHeaders(responseBuilder& response, const headerList& responseHeaders);
+
+  // The headers that differ from request to request: keep-alive, Date and the session cookie
+  void writeRequestHeaders(responseBuilder& response);
+
+  void sendResponse(responseBuilder& response, const char* body, size_t bodyLength);
+
+  fieldList headerFields;
+  fieldList parameterFields;
+
+  // Copies of the fields for getHeaders and getParameters, only built when asked for
+  std::map<std::string, std::string> headerMap;
+  std::map<std::string, std::string> parameterMap;
+  bool headerMapBuilt = false;
+  bool parameterMapBuilt = false;
 
   inline void parseRequestline();
   inline void parseHeaders();
 
-  void parseURLencodedData(const char* rawData);
-  void parseURLencodedData(std::string& rawData);
-  void parseURLencodedData(const char* rawData, const int length);
+  void parseURLencodedData(std::string_view rawData);
 
 public:
-  httpParser(packet* httpdata, connectionBase* conn, httpServer* srv);
+  /**
+   * @brief Create a parser for one request
+   *
+   * @param request The head of the request followed by its body, it has to outlive the parser
+   * @param requestMemory Where the parser allocates from, e.g. the requestArena of the connection
+   */
+  httpParser(std::string_view request, connectionBase* conn, httpServer* srv, std::pmr::memory_resource* requestMemory = std::pmr::get_default_resource());
   ~httpParser();
 
+  /**
+   * @brief Parse the request and call the endpoint it is for
+   */
   bool parse();
 
+  /**
+   * @brief Only parse the request line, headers and whatever body the request holds, without calling an endpoint
+   */
+  bool parseHead();
+
+  /**
+   * @brief Call the endpoint the parsed request is for, or respond with a 404
+   */
+  void dispatch();
+
+  /**
+   * @brief Start a session of class T for the client, or continue the one its cookie names
+   *
+   * @return The session, it stays valid until the parser is destroyed. Keep the data to use beyond the request in the session, not the pointer.
+   */
   template <class T>
   sessionBase* startSession();
 
-  void on(const std::string& method, const std::string& uri, const std::function<void(httpParser*)> callback);
-  void on(const std::string& ref, const std::function<void(httpParser*)> callback);
+  /**
+   * @brief Look up the endpoint the request is for, only done once per request
+   *
+   * @return The route of the endpoint, 0 if there is none
+   */
+  const router::route* matchRoute();
+
+  void respond(const std::string& status, const std::list<std::string>& responseHeaders, std::string_view body, const std::string& mimeType = "text/html");
+  void respond(const std::string& status, const std::list<std::string>& responseHeaders, const char* body, size_t bodyLength,
+      const std::string& mimeType = "text/html");
+
+  /**
+   * @brief Like respond, without allocating for the status or the headers
+   *
+   * @param status The status code, the reason phrase is added for known codes
+   * @param responseHeaders Complete header lines, e.g. "Cache-Control: no-cache"
+   */
+  void respond(unsigned int status, std::string_view body, std::string_view mimeType = "text/html", std::initializer_list<std::string_view> responseHeaders = {});
+
+  /**
+   * @brief Send a response that was serialized ahead of time, in one write. Only the status line and the headers depending on the request are added.
+   *
+   * @param serialized The rest of the head including its empty line, followed by the body. It's copied, so it may be shared between threads.
+   */
+  void respondSerialized(unsigned int status, std::string_view serialized);
+
+  /**
+   * @brief Respond with memory shared with other owners as the body, like a mapped file. The body isn't copied, it's held until it was sent.
+   */
+  void respondShared(const std::string& status, const std::list<std::string>& responseHeaders, std::shared_ptr<const char> body, size_t bodyLength,
+      const std::string& mimeType = "text/html");
+
+  /**
+   * @brief Respond with a range of an open file as the body. The body is sent straight from the file without copying it through userspace where the connection supports it.
+   *
+   * @param filefd The file, it has to stay open until the response is sent
+   * @param offset The first byte of the file to send
+   * @param length The amount of bytes to send
+   * @param fileOwner Whatever keeps the file open, it's held until the response is sent
+   */
+  void respondFile(const std::string& status, const std::list<std::string>& responseHeaders, int filefd, off_t offset, size_t length,
+      const std::string& mimeType = "text/html", std::shared_ptr<const void> fileOwner = std::shared_ptr<const void>());
+
+  /**
+   * @brief Send the headers of a response right away and stream its body through the returned writer, in the chunked encoding.
+   * HTTP/1.0 clients get the body unencoded and the connection is closed after it.
+   *
+   * The response has to be finished before the endpoint returns, which the writer does when it goes out of scope.
+   */
+  std::unique_ptr<responseWriter> respondChunked(const std::string& status, const std::list<std::string>& responseHeaders, const std::string& mimeType = "text/html");
+
+  /**
+   * @brief Respond with several ranges of an open file as a 206 multipart/byteranges body. Like respondFile the ranges are sent straight from the file.
+   *
+   * @param fileSize The size of the whole file, used in the Content-Range of every part
+   * @param ranges The ranges to send, in the order they are sent
+   */
+  void respondFileRanges(const std::list<std::string>& responseHeaders, int filefd, size_t fileSize, const std::vector<staticFile::byteRange>& ranges,
+      const std::string& mimeType = "text/html", std::shared_ptr<const void> fileOwner = std::shared_ptr<const void>());
+
+  /**
+   * @brief Respond with a body-less 304, telling the client its cached copy is still current
+   *
+   * @param responseHeaders The validators (ETag, Last-Modified) and caching headers the full response would have carried
+   */
+  void respondNotModified(const std::list<std::string>& responseHeaders);
+
+  /**
+   * @brief The value of a header, its name is compared case insensitively. Empty if the request doesn't have it.
+   */
+  std::string_view getHeader(std::string_view name);
+
+  /**
+   * @brief The value of a parameter from the query string or a form body. Empty if the request doesn't have it.
+   */
+  std::string_view getParameter(std::string_view name);
+
+  /**
+   * @brief The part of the path matched by a ':' or '*' segment of the endpoint's route. Empty if the route has no such parameter.
+   */
+  std::string_view getRouteParameter(std::string_view name);
+
+  size_t getHeaderCount();
+  const requestField& getHeaderField(size_t index);
+
+  size_t getParameterCount();
+  const requestField& getParameterField(size_t index);
+
+  /**
+   * @brief The headers as a map of copies, for handlers written against the old interface. Built on the first call.
+   */
+  std::map<std::string, std::string>& getHeaders();
+
+  /**
+   * @brief The parameters as a map of copies, for handlers written against the old interface. Built on the first call.
+   */
+  std::map<std::string, std::string>& getParameters();
+
+  static bool equalsIgnoreCase(std::string_view first, std::string_view second);
+
+  // The parts of the request point into the received request, which lives as long as the parser.
+  // Copy them to keep them beyond the endpoint.
+  std::string_view requestline;
+  std::string_view header;
+  std::string_view body;
+
+  // The key of the session the endpoint started, empty if it didn't start one
+  std::string_view sessionKey;
 
-  void respond(const std::string& status, const std::list<std::string>& responseHeaders, const std::string& body, const std::string& mimeType = "text/html");
+  /**
+   * @brief Set when the response can only be delimited by closing the connection, keep-alive is then ignored
+   */
+  bool closeConnection = false;
 
-  std::string requestline;
-  std::string header;
-  std::string body;
+  /**
+   * @brief For endpoints added with httpServer::onStream. Called with every piece of the request body as it arrives, body stays empty.
+   * Reading from the connection waits while it runs.
+   */
+  std::function<void(const char* data, size_t length)> onBodyChunk;
 
-  const std::string* sessionKey = 0;
+  /**
+   * @brief For endpoints added with httpServer::onStream. Called once the whole body went through onBodyChunk, this is where the response is sent.
+   * It isn't called if the connection fails before the body is complete.
+   */
+  std::function<void()> onBodyEnd;
 
-  std::string method;
-  std::string path;
-  std::map<std::string, std::string> parameters;
-  std::map<std::string, std::string> headers;
+  std::string_view method;
+  std::string_view path;
+  std::string_view query;
 };
 } // namespace kleins
 
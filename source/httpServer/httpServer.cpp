@@ -84,31 +84,49 @@ std::map<std::string, std::string> kleins::httpServer::mimeLookup = {
     /* 3GPP2 audio/video container  */ {".3g2", "video/3gpp2"}, // audio/3gpp2 if it doesn't contain video
     /* 7-zip archive                */ {".7z", "application/x-7z-compressed"}};
 
-std::map<kleins::httpMethod, std::string> kleins::httpServer::methodLookup = {
-    {kleins::httpMethod::GET, "GET"},         {kleins::httpMethod::HEAD, "HEAD"},     {kleins::httpMethod::POST, "POST"},
-    {kleins::httpMethod::PUT, "PUT"},         {kleins::httpMethod::DELETE, "DELETE"}, {kleins::httpMethod::CONNECT, "CONNECT"},
-    {kleins::httpMethod::OPTIONS, "OPTIONS"}, {kleins::httpMethod::TRACE, "TRACE"},   {kleins::httpMethod::PATCH, "PATCH"},
-};
-
-kleins::httpServer::httpServer(/* args */) {
+kleins::httpServer::httpServer(unsigned int ioThreads) {
+  loop = new eventLoop(ioThreads);
+  cache = new fileCache(64 * 1024 * 1024, 1024 * 1024);
   sessionCleanupThread = new std::thread(cleanUpSessionLoop, this);
 }
 
 kleins::httpServer::~httpServer() {
+  keepRunning = false;
+
+  sessionCleanupThread->join();
+  delete sessionCleanupThread;
+
+  // Stop taking in work before anything it uses goes away: no new connections, then no more I/O,
+  // then let the callbacks that are still running on the pool finish
+  for (auto& socket : sockets) {
+    socket->stopTicks();
+  }
+
+  loop->stop();
+
+  delete pool;
+  pool = 0;
+
+  sockets.clear();
+  delete loop;
+
+  // Only written once no request can start or restore a session anymore
+  if (snapshot.load() != 0) {
+    snapshot.load()->write(sessions);
+    delete snapshot.load();
+  }
+
   if (mServer != 0) {
-    delete mServer;
+    // The destructor isn't virtual, so the metricsServer has to be deleted as one
+    delete (metrics::metricsServer*)mServer;
     delete metric_totalAcccess;
+    delete metric_access;
     delete metric_notfound;
     delete metric_totalSessions;
     delete metric_activeSessions;
   }
 
-  keepRunning = false;
-
-  sessionCleanupThread->join();
-  delete sessionCleanupThread;
-
-  sockets.clear();
+  delete cache;
 }
 
 bool kleins::httpServer::addSocket(socketBase* socket) {
@@ -119,6 +137,8 @@ bool kleins::httpServer::addSocket(socketBase* socket) {
   socket->newConnectionCallback = [this](connectionBase* conn) {
     if (conn->getAlive()) {
       this->newConnection(conn);
+    } else {
+      delete conn;
     }
   };
 
@@ -131,84 +151,368 @@ bool kleins::httpServer::addSocket(socketBase* socket) {
 }
 
 void kleins::httpServer::newConnection(kleins::connectionBase* conn) {
+  std::shared_ptr<connectionState> state(new connectionState);
+  state->reader = requestReader(limits);
+
+  conn->setTimeouts(timeouts);
+
+  conn->onRecieveCallback = [this, conn, state](std::unique_ptr<kleins::packet> packet) {
+    state->reader.feed(packet->data.data(), packet->data.length());
+    processInput(conn, state);
+  };
+
+  if (conn->usesEventLoop()) {
+    loop->addConnection(conn);
+  }
+}
+
+void kleins::httpServer::processInput(kleins::connectionBase* conn, std::shared_ptr<connectionState> state) {
+  requestReader& reader = state->reader;
 
-  conn->onRecieveCallback = [this, conn](std::unique_ptr<kleins::packet> packet) {
-    auto parser = std::unique_ptr<kleins::httpParser>(new kleins::httpParser(packet.get(), conn, this));
+  // Pipelined requests are answered one after another, the next one is only looked at once the previous one is done
+  while (!conn->getReadingPaused() && conn->getAlive()) {
+    requestReader::readState readState = reader.advance();
 
-    for (auto cb : this->functionTable) {
-      parser->on(cb.first, cb.second);
+    if (readState >= requestReader::READ_MALFORMED) {
+      state->stream.reset();
+      rejectRequest(conn, readState);
+      return;
     }
 
-    parser.get()->parse();
+    if (reader.takeHeadReady()) {
+      setReadPhase(conn, state.get(), READ_PHASE_IDLE);
+
+      if (hasStreamRoutes) {
+        std::shared_ptr<streamedRequest> stream = startStream(conn, reader.getHead());
+
+        if (stream) {
+          reader.streamBody();
+          state->stream = stream;
 
-    if (parser->headers["Connection"] != "keep-alive") {
-      conn->close_socket();
+          if (!runRequestStep(conn, state, [stream]() {
+                stream->parser->dispatch();
+                return true;
+              })) {
+            return;
+          }
+        }
+      }
+      continue;
     }
-  };
 
-  if (conn->onRecieveCallback) {
-    conn->startOwnTickLoop();
+    if (state->stream) {
+      std::shared_ptr<streamedRequest> stream = state->stream;
+
+      std::string chunk;
+      reader.takeBody(chunk);
+
+      if (!chunk.empty()) {
+        if (!runRequestStep(conn, state, [stream, chunk]() {
+              if (stream->parser->onBodyChunk) {
+                stream->parser->onBodyChunk(chunk.data(), chunk.length());
+              }
+              return true;
+            })) {
+          return;
+        }
+        continue;
+      }
+    }
+
+    if (readState != requestReader::READ_COMPLETE) {
+      if (reader.takeContinueRequest()) {
+        const std::string continueResponse = "HTTP/1.1 100 Continue\r\n\r\n";
+        conn->sendData(continueResponse.c_str(), continueResponse.length());
+      }
+
+      // Streamed bodies can be as big as the endpoint likes, only the idle timeout applies to them
+      if (!reader.hasPartialRequest() || state->stream) {
+        setReadPhase(conn, state.get(), READ_PHASE_IDLE);
+      } else {
+        setReadPhase(conn, state.get(), readState == requestReader::READ_HEAD ? READ_PHASE_HEAD : READ_PHASE_BODY);
+      }
+      return;
+    }
+
+    setReadPhase(conn, state.get(), READ_PHASE_IDLE);
+
+    if (state->stream) {
+      std::shared_ptr<streamedRequest> stream = state->stream;
+
+      reader.reset();
+      state->stream.reset();
+
+      if (!runRequestStep(conn, state, [this, conn, stream]() {
+            if (stream->parser->onBodyEnd) {
+              stream->parser->onBodyEnd();
+            }
+            return finishRequest(conn, stream->parser.get());
+          })) {
+        return;
+      }
+      continue;
+    }
+
+    std::string_view request = reader.takeRequest(state->arena);
+
+    if (!runRequestStep(conn, state, [this, conn, state, request]() { return handleRequest(conn, state.get(), request); })) {
+      return;
+    }
+  }
+}
+
+bool kleins::httpServer::runRequestStep(kleins::connectionBase* conn, std::shared_ptr<connectionState> state, std::function<bool()> step) {
+  // Connections that drive their own I/O can't take responses from other threads, they are always handled inline
+  if (!pool || !conn->usesEventLoop()) {
+    return step();
+  }
+
+  // Stop reading until this step is done, that keeps responses in order and bounds the work per connection
+  conn->pauseReading();
+  conn->requestStarted();
+
+  pool->submit([this, conn, state, step]() {
+    bool keepGoing = step();
+
+    conn->runOnLoop([this, conn, state, keepGoing]() {
+      conn->resumeReading();
+      conn->requestDone();
+
+      if (keepGoing) {
+        processInput(conn, state);
+      }
+    });
+  });
+
+  return false;
+}
+
+std::shared_ptr<kleins::httpServer::streamedRequest> kleins::httpServer::startStream(kleins::connectionBase* conn, const std::string& head) {
+  std::shared_ptr<streamedRequest> stream(new streamedRequest);
+
+  stream->head.data = head;
+  stream->head.size = head.length();
+  stream->parser.reset(new kleins::httpParser(stream->head.data, conn, this));
+  stream->parser->parseHead();
+
+  const router::route* matched = stream->parser->matchRoute();
+  if (!matched || !matched->streamed) {
+    return std::shared_ptr<streamedRequest>();
+  }
+
+  return stream;
+}
+
+void kleins::httpServer::rejectRequest(kleins::connectionBase* conn, requestReader::readState error) {
+  std::string status = "400 Bad Request";
+
+  if (error == requestReader::READ_HEAD_TOO_LARGE) {
+    status = "431 Request Header Fields Too Large";
+  } else if (error == requestReader::READ_BODY_TOO_LARGE) {
+    status = "413 Content Too Large";
+  }
+
+  // The rest of the input can't be framed anymore, so the connection has to go
+  std::string response = "HTTP/1.1 " + status + "\r\ncontent-length: 0\r\nConnection: close\r\nServer: kleinsHTTP\r\n\r\n";
+
+  conn->sendData(response.c_str(), response.length());
+  conn->closeAfterFlush();
+}
+
+void kleins::httpServer::setReadPhase(kleins::connectionBase* conn, connectionState* state, readPhase phase) {
+  // The deadline of a phase starts when the phase does, more input arriving doesn't extend it
+  if (phase == state->phase) {
+    return;
+  }
+
+  state->phase = phase;
+
+  if (phase == READ_PHASE_HEAD) {
+    conn->setReadDeadline(conn->getTimeouts().header);
+  } else if (phase == READ_PHASE_BODY) {
+    conn->setReadDeadline(conn->getTimeouts().body);
+  } else {
+    conn->clearReadDeadline();
+  }
+}
+
+bool kleins::httpServer::handleRequest(kleins::connectionBase* conn, connectionState* state, std::string_view request) {
+  requestArena& arena = state->arena;
+
+  // Requests of a connection are handled one at a time, so the parser can live in the arena along with the request
+  httpParser* parser = new (arena.allocate(sizeof(httpParser), alignof(httpParser))) httpParser(request, conn, this, arena.getResource());
+
+  parser->parse();
+  bool keepAlive = finishRequest(conn, parser);
+
+  parser->~httpParser();
+  arena.reset();
+
+  return keepAlive;
+}
+
+bool kleins::httpServer::finishRequest(kleins::connectionBase* conn, kleins::httpParser* parser) {
+  // HTTP/1.1 connections stay open unless the client asks otherwise, HTTP/1.0 ones only if the client asks for it
+  std::string_view connection = parser->getHeader("Connection");
+
+  bool keepAlive;
+  if (parser->requestline.length() >= 8 && parser->requestline.compare(parser->requestline.length() - 8, 8, "HTTP/1.1") == 0) {
+    keepAlive = !httpParser::equalsIgnoreCase(connection, "close");
+  } else {
+    keepAlive = httpParser::equalsIgnoreCase(connection, "keep-alive");
+  }
+
+  if (parser->closeConnection) {
+    keepAlive = false;
+  }
+
+  if (!keepAlive) {
+    conn->closeAfterFlush();
   }
 
-  std::thread([conn]() {
-    conn->join();
-    delete conn;
-  }).detach();
+  return keepAlive;
+}
+
+void kleins::httpServer::setRequestLimits(const requestLimits& serverLimits) {
+  limits = serverLimits;
+}
+
+void kleins::httpServer::setConnectionTimeouts(const connectionTimeouts& serverTimeouts) {
+  timeouts = serverTimeouts;
+
+  if (timeouts.idle) {
+    keepAliveHeader = "Keep-Alive: timeout=" + std::to_string(timeouts.idle / 1000);
+  } else {
+    keepAliveHeader.clear();
+  }
+}
+
+void kleins::httpServer::setFileCache(size_t budgetBytes, size_t maxFileSizeBytes) {
+  cache->setLimits(budgetBytes, maxFileSizeBytes);
+}
+
+void kleins::httpServer::startWorkerPool(unsigned int threadCount) {
+  if (pool) {
+    return;
+  }
+
+  pool = new workerPool(threadCount);
 }
 
 void kleins::httpServer::on(httpMethod method, const std::string& uri, const std::function<void(httpParser*)> callback) {
-  std::string ref;
-  ref.reserve(methodLookup[method].length() + uri.length() + 1);
+  addRoute(method, uri, callback, false, true);
+}
 
-  ref = methodLookup[method];
-  ref.append(uri);
+void kleins::httpServer::onStream(httpMethod method, const std::string& uri, const std::function<void(httpParser*)> callback) {
+  hasStreamRoutes = true;
+  addRoute(method, uri, callback, true, true);
+}
+
+void kleins::httpServer::addRoute(
+    httpMethod method, const std::string& uri, const std::function<void(httpParser*)> callback, bool streamed, bool patterns) {
+  std::function<void(httpParser*)> handler = callback;
 
   if (mServer) {
+    // Requests are counted per route, so paths with parameters share one bucket
+    std::string bucketName = "handler=\"" + uri + "\"";
+    metric_access->addBucket(bucketName.c_str());
 
-    std::string handler = "handler=\"" + uri + "\"";
-    metric_access->addBucket(handler.c_str());
+    metrics::counterBucketMetricData* bucket = (*metric_access)[bucketName.c_str()];
 
-    functionTable.insert(std::make_pair(ref, [this, callback](httpParser* parser) {
+    handler = [this, bucket, callback](httpParser* parser) {
       metric_totalAcccess->inc();
-      std::string handler = "handler=\"" + parser->path + "\"";
-      (*metric_access)[handler.c_str()]->inc();
+      bucket->inc();
       callback(parser);
-    }));
-    return;
+    };
+  }
+
+  if (!routes.add(method, uri, handler, streamed, patterns)) {
+    exit(EXIT_FAILURE);
   }
-  functionTable.insert(std::make_pair(ref, callback));
 }
 
-void kleins::httpServer::serve(const std::string& uri, const std::string& path) {
-  if (!std::filesystem::exists(path)) {
+void kleins::httpServer::serve(const std::string& uri, const std::string& path, const std::string& cacheControl) {
+  std::string mimetype = "text/html";
+
+  auto knownType = mimeLookup.find(std::filesystem::path(path).extension());
+  if (knownType != mimeLookup.end()) {
+    mimetype = knownType->second;
+  }
+
+  staticFile* file = new staticFile(path, mimetype, cacheControl);
+
+  if (!file->isLoaded()) {
     std::cerr << "Error loading file " << path << std::endl;
     exit(EXIT_FAILURE);
   }
 
-  uint32_t filesize = std::filesystem::file_size(path);
-  std::string filedata;
+  staticFiles.push_back(std::unique_ptr<staticFile>(file));
 
-  filedata.resize(filesize);
+  addRoute(GET, uri, [this, file](httpParser* parser) { serveFile(parser, file); }, false, false);
+}
 
-  std::basic_ifstream<char> instream(path, std::ios::binary);
+void kleins::httpServer::serveFile(httpParser* parser, staticFile* file) {
+  std::string_view ifNoneMatch = parser->getHeader("If-None-Match");
+  std::string_view ifModifiedSince = parser->getHeader("If-Modified-Since");
+  std::string_view range = parser->getHeader("Range");
 
-  instream.read(&filedata[0], filesize);
+  // Plain requests for small files get the response serialized when the file was added
+  if (ifNoneMatch.empty() && ifModifiedSince.empty() && range.empty() && !file->getSerializedResponse().empty()) {
+    parser->respondSerialized(200, file->getSerializedResponse());
+    return;
+  }
 
-  fileLookup.insert(std::make_pair(uri, filedata));
+  if (file->isNotModified(ifNoneMatch, ifModifiedSince)) {
+    parser->respondNotModified(file->getHeaders());
+    return;
+  }
 
-  on(GET, uri, [this](httpParser* parser) {
-    std::string extension = std::filesystem::path(parser->path).extension();
-    std::string mimetype = mimeLookup[extension];
+  std::vector<staticFile::byteRange> ranges;
+  bool partial = file->requestedRanges(range, parser->getHeader("If-Range"), ranges);
 
-    if (mimeLookup.find(extension) != mimeLookup.end()) {
-      parser->respond("200", {}, fileLookup[parser->path], mimetype);
-    } else {
-      parser->respond("200", {}, fileLookup[parser->path]);
+  if (partial && ranges.empty()) {
+    std::list<std::string> rangeHeaders = file->getHeaders();
+    rangeHeaders.push_back("Content-Range: bytes */" + std::to_string(file->getSize()));
+    parser->respond("416", rangeHeaders, "");
+    return;
+  }
+
+  if (!partial) {
+    std::shared_ptr<const char> contents = cache->get(file);
+
+    if (contents) {
+      parser->respondShared("200", file->getHeaders(), std::move(contents), file->getSize(), file->getMimeType());
+      return;
     }
-  });
+  }
+
+  // Everything else is sent straight from the file, which is only open while responses send it
+  std::shared_ptr<const staticFile::descriptor> opened = file->openDescriptor();
+  if (!opened) {
+    parser->respond(500, "<html><head></head><body>Internal Server Error</body></html>\r\n");
+    return;
+  }
+
+  if (!partial) {
+    parser->respondFile("200", file->getHeaders(), opened->fd, 0, file->getSize(), file->getMimeType(), opened);
+    return;
+  }
+
+  std::list<std::string> rangeHeaders = file->getHeaders();
+
+  if (ranges.size() == 1) {
+    const staticFile::byteRange& range = ranges.front();
+
+    rangeHeaders.push_back("Content-Range: bytes " + std::to_string(range.offset) + "-" + std::to_string(range.offset + range.length - 1) + "/" +
+                           std::to_string(file->getSize()));
+    parser->respondFile("206", rangeHeaders, opened->fd, range.offset, range.length, file->getMimeType(), opened);
+    return;
+  }
+
+  parser->respondFileRanges(rangeHeaders, opened->fd, file->getSize(), ranges, file->getMimeType(), opened);
 }
 
-void kleins::httpServer::serveDirectory(const std::string& baseuri, const std::string& path, const std::string indexFile) {
+void kleins::httpServer::serveDirectory(const std::string& baseuri, const std::string& path, const std::string indexFile, const std::string& cacheControl) {
   if (!std::filesystem::exists(path)) {
     std::cerr << "Error loading directory " << path << std::endl;
     exit(EXIT_FAILURE);
@@ -221,17 +525,20 @@ void kleins::httpServer::serveDirectory(const std::string& baseuri, const std::s
     std::string filepath = p.path();
 
     if (p.path().filename() == indexFile) {
-      serve(((std::string)p.path().parent_path()).append("/").substr(path.length()), p.path());
+      serve(((std::string)p.path().parent_path()).append("/").substr(path.length()), p.path(), cacheControl);
 
       std::string incompletePath = ((std::string)p.path().parent_path()).substr(path.length());
       if (incompletePath.length() != 0) {
-        on(GET, incompletePath, [](httpParser* parser) {
-          std::string locationHeader = "Location: " + parser->path + "/";
-          parser->respond("301", {locationHeader}, "");
-        });
+        addRoute(
+            GET, incompletePath,
+            [](httpParser* parser) {
+              std::string locationHeader = "Location: " + std::string(parser->path) + "/";
+              parser->respond("301", {locationHeader}, "");
+            },
+            false, false);
       }
     } else {
-      serve(filepath.substr(path.length()), p.path());
+      serve(filepath.substr(path.length()), p.path(), cacheControl);
     }
   }
 }
@@ -241,30 +548,35 @@ void kleins::httpServer::printVersion() {
 }
 
 void kleins::httpServer::cleanUpSessionLoop(httpServer* server) {
-  while (server->keepRunning) {
-
-    std::map<std::string, sessionBase*>::iterator it = server->sessions.begin();
-
-    auto currentTime = std::chrono::system_clock::now();
-
-    while (it != server->sessions.end()) {
-      sessionBase* sb = it->second;
+  auto lastSnapshot = std::chrono::steady_clock::now();
 
-      if (sb->expireTime < currentTime) {
-        server->sessions.erase(it);
+  while (server->keepRunning) {
+    // Only touches the sessions that are due, so it can run often
+    if (server->sessions.expire() > 0 && server->metric_activeSessions) {
+      server->metric_activeSessions->set(server->sessions.size());
+    }
 
-        server->metric_activeSessions->set(server->metric_activeSessions->get() - 1);
+    sessionSnapshot* snapshot = server->snapshot.load(std::memory_order_acquire);
 
-        delete sb;
-      }
-
-      it++;
+    if (snapshot && server->snapshotInterval > 0 && std::chrono::steady_clock::now() - lastSnapshot >= std::chrono::seconds(server->snapshotInterval)) {
+      snapshot->write(server->sessions);
+      lastSnapshot = std::chrono::steady_clock::now();
     }
 
-    usleep(5000000);
+    usleep(1000000);
   }
 }
 
+void kleins::httpServer::setSessionSnapshot(const std::string& path, unsigned int intervalSeconds) {
+  if (snapshot.load() != 0) {
+    std::cerr << "Error setting the session snapshot: it was already set" << std::endl;
+    return;
+  }
+
+  snapshotInterval = intervalSeconds;
+  snapshot.store(new sessionSnapshot(path), std::memory_order_release);
+}
+
 void kleins::httpServer::startMetricsServer(uint16_t port) {
   metric_totalAcccess = new metrics::counterMetric("total_accesses", "The total ammount of access done to this server");
   metric_access = new metrics::histogramMetric("access", "What urls were accessed");
@@ -280,4 +592,7 @@ void kleins::httpServer::startMetricsServer(uint16_t port) {
   ((metrics::metricsServer*)mServer)->addMetric(metric_notfound);
   ((metrics::metricsServer*)mServer)->addMetric(metric_activeSessions);
   ((metrics::metricsServer*)mServer)->addMetric(metric_totalSessions);
+  ((metrics::metricsServer*)mServer)->addMetric(cache->metric_hits);
+  ((metrics::metricsServer*)mServer)->addMetric(cache->metric_misses);
+  ((metrics::metricsServer*)mServer)->addMetric(cache->metric_residentBytes);
 }
\ No newline at end of file
@@ -1,21 +1,36 @@
 #ifndef HTTPSERVER_H
 #define HTTPSERVER_H
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <list>
 #include <openssl/rand.h>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
 
 #ifndef SINGLE_HEADER
 #include "../connectionBase/connectionBase.h"
 #include "../counterMetric/counterMetric.h"
+#include "../eventLoop/eventLoop.h"
+#include "../fileCache/fileCache.h"
 #include "../gaugeMetric/gaugeMetric.h"
 #include "../histogramMetric/histogramMetric.h"
 #include "../httpParser/httpParser.h"
 #include "../packet/packet.h"
+#include "../requestArena/requestArena.h"
+#include "../requestReader/requestReader.h"
+#include "../routeTable/routeTable.h"
+#include "../router/router.h"
 #include "../sessionBase/sessionBase.h"
+#include "../sessionPool/sessionPool.h"
+#include "../sessionSnapshot/sessionSnapshot.h"
+#include "../sessionStore/sessionStore.h"
 #include "../socketBase/socketBase.h"
+#include "../staticFile/staticFile.h"
 #include "../tcpSocket/tcpSocket.h"
+#include "../workerPool/workerPool.h"
 #endif
 
 #ifndef BUILD_VERSION
@@ -26,8 +41,6 @@ namespace kleins {
 
 class httpParser;
 
-typedef enum httpMethod { GET, HEAD, POST, PUT, DELETE, CONNECT, OPTIONS, TRACE, PATCH } httpMethod;
-
 /**
  * @brief An httpserver that will take care of connection managment, serving of static files and api endpoints
  * 
@@ -35,8 +48,20 @@ typedef enum httpMethod { GET, HEAD, POST, PUT, DELETE, CONNECT, OPTIONS, TRACE,
  * 
  */
 class httpServer {
+  friend class httpParser;
+
 private:
-  std::map<std::string, sessionBase*> sessions;
+  // A pool for every class sessions are started with. Declared before the sessions, which are returned to them when they are destroyed.
+  std::unordered_map<std::type_index, std::unique_ptr<sessionPoolBase>> sessionPools;
+  std::mutex sessionPoolMutex;
+
+  template <class T> sessionPool<T>* getSessionPool();
+
+  sessionStore sessions;
+
+  // Set once by setSessionSnapshot, the cleanup thread writes it every snapshotInterval seconds
+  std::atomic<sessionSnapshot*> snapshot{0};
+  unsigned int snapshotInterval = 0;
 
   std::thread* sessionCleanupThread;
   static void cleanUpSessionLoop(httpServer* server);
@@ -45,13 +70,72 @@ private:
 
   std::list<std::unique_ptr<socketBase>> sockets;
 
-  std::map<std::string, const std::function<void(httpParser*)>> functionTable;
-  std::map<std::string, std::string> fileLookup;
+  eventLoop* loop = 0;
+  workerPool* pool = 0;
+
+  router routes;
+
+  // A table added with on(routeTable), dispatched through a plain function that knows its type
+  struct compiledRouteTable {
+    const void* table;
+    bool (*dispatch)(const void* table, httpParser* parser);
+  };
+
+  template <class table> static bool dispatchRouteTable(const void* routes, httpParser* parser);
+
+  // The tables added with on(routeTable) and every list of them published so far, the newest table first. Adding a table publishes a new
+  // list instead of changing the current one, the old ones are kept until the server is destroyed because requests may still be walking them.
+  std::list<std::shared_ptr<const void>> routeTableStorage;
+  std::list<std::vector<compiledRouteTable>> routeTables;
+  std::atomic<const std::vector<compiledRouteTable>*> compiledRoutes{0};
+  std::mutex routeTableMutex;
+  std::list<std::unique_ptr<staticFile>> staticFiles;
+  fileCache* cache = 0;
 
   void newConnection(connectionBase* conn);
+  requestLimits limits;
+  connectionTimeouts timeouts;
+
+  // Tells keep-alive clients the idle timeout, so they don't reuse a connection the server is about to close
+  std::string keepAliveHeader = "Keep-Alive: timeout=30";
+
+  // Whether any endpoint was added with onStream, requests only have to be checked for one then
+  bool hasStreamRoutes = false;
+
+  // A request for an onStream endpoint whose body is still coming in
+  struct streamedRequest {
+    packet head;
+    std::unique_ptr<httpParser> parser;
+  };
+
+  // Which read deadline of the connection is running for the request it is receiving
+  enum readPhase {
+    READ_PHASE_IDLE,
+    READ_PHASE_HEAD,
+    READ_PHASE_BODY,
+  };
+
+  // What a connection has read of the request it is currently receiving
+  struct connectionState {
+    requestReader reader;
+    std::shared_ptr<streamedRequest> stream;
+    readPhase phase = READ_PHASE_IDLE;
+
+    // Holds the request being handled and its parser, emptied once it is answered
+    requestArena arena;
+  };
+
+  void processInput(connectionBase* conn, std::shared_ptr<connectionState> state);
+  bool runRequestStep(connectionBase* conn, std::shared_ptr<connectionState> state, std::function<bool()> step);
+  std::shared_ptr<streamedRequest> startStream(connectionBase* conn, const std::string& head);
+  bool handleRequest(connectionBase* conn, connectionState* state, std::string_view request);
+  bool finishRequest(connectionBase* conn, httpParser* parser);
+  void rejectRequest(connectionBase* conn, requestReader::readState error);
+  void setReadPhase(connectionBase* conn, connectionState* state, readPhase phase);
+  void serveFile(httpParser* parser, staticFile* file);
+  void addRoute(httpMethod method, const std::string& uri, const std::function<void(httpParser*)> callback, bool streamed, bool patterns);
 
   static std::map<std::string, std::string> mimeLookup;
-  static std::map<httpMethod, std::string> methodLookup;
 
   httpServer* mServer = 0;
 
@@ -64,8 +148,9 @@ public:
   /**
    * @brief httpServer constructor
    * 
+   * @param ioThreads The amount of threads that handle connections. 0 uses one per core.
    */
-  httpServer(/* args */);
+  httpServer(unsigned int ioThreads = 0);
 
   /**
    * @brief Destroy the http Server object
@@ -77,7 +162,8 @@ public:
    * @brief Add an endpoint to the httpServer
    * 
    * @param method The method of the endpoint
-   * @param uri The url to respond to on ('/', 'api/hello') 
+   * @param uri The url to respond to on ('/', 'api/hello'). Segments starting with ':' match any segment and a last segment starting with '*'
+   * matches the rest of the path ('/users/:id', or '*path' as the last segment of '/files'), the endpoint gets them from parser->getRouteParameter.
    * @param callback The callback function that gets triggered when a client acces it.
    * 
    * Example:
@@ -86,17 +172,56 @@ public:
    * server.on(kleins::httpMethod::GET,"/hello",[](httpParser* parser){
    *    data->respond("200",{},"Hello!");
    * });
+   *
+   * server.on(kleins::httpMethod::GET,"/users/:id",[](httpParser* parser){
+   *    parser->respond("200",{},parser->getRouteParameter("id"));
+   * });
    * \endcode
    */
   void on(httpMethod method, const std::string& uri, const std::function<void(httpParser*)> callback);
 
+  /**
+   * @brief Add the endpoints of a routeTable, which dispatches without going through std::function or the route tree.
+   * They are looked up before the endpoints added with on(method, uri, callback), tables added later before the ones added earlier.
+   * Requests to them are counted in the total of the metrics server, but not per handler.
+   */
+  template <class... handlers>
+  void on(const routeTable<handlers...>& table);
+
+  /**
+   * @brief Add an endpoint that receives the request body piece by piece while it arrives instead of all at once
+   *
+   * The callback runs as soon as the headers are in. It sets parser->onBodyChunk, which then gets every piece of the body,
+   * and parser->onBodyEnd, which responds once the body is complete. Reading from the connection waits while either runs,
+   * so a slow consumer holds back the client instead of the body piling up in memory. requestLimits::maxBodySize doesn't apply.
+   *
+   * Example:
+   *
+   * \code{.cpp}
+   * server.onStream(kleins::httpMethod::POST, "/upload", [](httpParser* parser) {
+   *    auto file = std::make_shared<std::ofstream>("upload.bin", std::ios::binary);
+   *    parser->onBodyChunk = [file](const char* data, size_t length) { file->write(data, length); };
+   *    parser->onBodyEnd = [parser]() { parser->respond("200", {}, "Stored"); };
+   * });
+   * \endcode
+   */
+  void onStream(httpMethod method, const std::string& uri, const std::function<void(httpParser*)> callback);
+
   /**
    * @brief Serve a localfile under a path
-   * 
+   *
+   * The response for files up to 16 KiB is put together here, headers and content, and sent with a single write on every request.
+   * Bigger files are sent from the file cache or straight from disk.
+   *
+   * The file is read once here and closed again, it only takes a descriptor while responses are sending it from disk,
+   * one per file however many responses send it at once. The file shouldn't change while it's served, responses for it fail with a 500 then.
+   *
    * @param uri The url the file should be provided under
    * @param path The local path of the file
+   * @param cacheControl The Cache-Control header to send with the file, e.g. "public, max-age=31536000, immutable" for fingerprinted files.
+   * None is sent if it's empty, clients then revalidate with the ETag or Last-Modified date.
    */
-  void serve(const std::string& uri, const std::string& path);
+  void serve(const std::string& uri, const std::string& path, const std::string& cacheControl = "");
 
   /**
    * @brief Automaticly serve a directory recursivly
@@ -104,8 +229,11 @@ public:
    * @param baseuri The parent path of all the files ('/','static/')
    * @param path The path of the local files to be served
    * @param indexFile Set the name of the index files that will also be avaliable under /
+   * @param cacheControl The Cache-Control header to send with all files of the directory, see serve()
+   *
+   * Every file is read once, the files don't stay open, so directories with more files than the descriptor limit can be served. See serve().
    */
-  void serveDirectory(const std::string& baseuri, const std::string& path, const std::string indexFile = "index.html");
+  void serveDirectory(const std::string& baseuri, const std::string& path, const std::string indexFile = "index.html", const std::string& cacheControl = "");
 
   /**
    * @brief Add a socket to listen on
@@ -124,9 +252,58 @@ public:
 
   void startMetricsServer(uint16_t port);
 
+  /**
+   * @brief Set the size limits for requests on connections accepted from now on
+   */
+  void setRequestLimits(const requestLimits& serverLimits);
+
+  /**
+   * @brief Set the timeouts of connections accepted from now on
+   *
+   * Clients that send the head of a request slower than the header timeout, or its body slower than the body timeout, are disconnected,
+   * however much they trickle in. Keep-alive responses announce the idle timeout in their Keep-Alive header.
+   */
+  void setConnectionTimeouts(const connectionTimeouts& serverTimeouts);
+
+  /**
+   * @brief Run endpoint callbacks on a pool of worker threads instead of the threads doing the I/O
+   *
+   * Slow callbacks then only hold up their own request, and the amount of callbacks running at once is capped at the pool size.
+   * Connections of sockets that drive their own I/O (uringSocket) are still handled inline.
+   *
+   * @param threadCount The amount of worker threads. 0 uses one per core.
+   */
+  void startWorkerPool(unsigned int threadCount = 0);
+
+  /**
+   * @brief Configure the cache that keeps small, frequently requested static files mapped in memory
+   *
+   * Files that aren't cached are sent straight from disk. The cache starts out with a 64 MiB budget and caches files up to 1 MiB.
+   *
+   * @param budgetBytes The amount of memory all cached files may take up together, least recently used files are evicted beyond it. 0 disables the cache.
+   * @param maxFileSizeBytes Files bigger than this are never cached
+   */
+  void setFileCache(size_t budgetBytes, size_t maxFileSizeBytes = 1024 * 1024);
+
+  /**
+   * @brief Keep the sessions in a snapshot file, so users stay logged in when the server restarts
+   *
+   * The sessions of the snapshot the previous run left there aren't read up front. Each one is restored when the first request with its key
+   * starts a session, through sessionBase::deserialize of the class that request starts. Call it once, before the server gets requests.
+   *
+   * @param path The snapshot file
+   * @param intervalSeconds How often the snapshot is written. 0 only writes it when the server is destroyed.
+   */
+  void setSessionSnapshot(const std::string& path, unsigned int intervalSeconds = 60);
+
   metrics::counterMetric* metric_notfound = 0;
 
-  template <class T> sessionBase* startSession(std::string& authKey);
+  /**
+   * @brief Continue the session stored under authKey, or start a new one of class T. Endpoints use httpParser::startSession instead.
+   *
+   * @return The session, the caller holds a reference to it and gives it back with sessionStore::release
+   */
+  template <class T> sessionBase* startSession(std::string_view authKey);
 };
 
 }; // namespace kleins
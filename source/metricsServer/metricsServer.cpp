@@ -1,6 +1,6 @@
 #include "metricsServer.h"
 
-kleins::metrics::metricsServer::metricsServer(/* args */) {
+kleins::metrics::metricsServer::metricsServer(/* args */) : httpServer(1) {
   on(GET, "/metrics", [this](httpParser* parser) {
     std::stringstream ss;
 
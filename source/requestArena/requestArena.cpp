@@ -0,0 +1,26 @@
+#include "requestArena.h"
+
+kleins::requestArena::requestArena() : resource(buffer, inlineSize, std::pmr::new_delete_resource()) {
+}
+
+kleins::requestArena::~requestArena() {
+}
+
+std::pmr::memory_resource* kleins::requestArena::getResource() {
+  return &resource;
+}
+
+void* kleins::requestArena::allocate(size_t size, size_t alignment) {
+  return resource.allocate(size, alignment);
+}
+
+std::string_view kleins::requestArena::copy(std::string_view data) {
+  char* target = (char*)resource.allocate(std::max<size_t>(data.length(), 1), 1);
+  memcpy(target, data.data(), data.length());
+
+  return std::string_view(target, data.length());
+}
+
+void kleins::requestArena::reset() {
+  resource.release();
+}
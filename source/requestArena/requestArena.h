@@ -0,0 +1,53 @@
+#ifndef REQUESTARENA_H
+#define REQUESTARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+
+namespace kleins {
+
+/**
+ * @brief Memory for the request a connection is currently handling.
+ *
+ * Allocations are bumped off a buffer that is part of the arena, only requests that need more than that reach the heap.
+ * Nothing is freed on its own, reset() drops everything at once after the request was answered.
+ * An arena belongs to one connection, which only handles one request at a time, so it isn't locked.
+ */
+class requestArena {
+public:
+  static const size_t inlineSize = 8 * 1024;
+
+private:
+  alignas(std::max_align_t) char buffer[inlineSize];
+  std::pmr::monotonic_buffer_resource resource;
+
+public:
+  requestArena();
+  ~requestArena();
+
+  requestArena(const requestArena&) = delete;
+  requestArena& operator=(const requestArena&) = delete;
+
+  /**
+   * @brief The arena as a memory resource for pmr containers
+   */
+  std::pmr::memory_resource* getResource();
+
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /**
+   * @brief Copy data into the arena
+   */
+  std::string_view copy(std::string_view data);
+
+  /**
+   * @brief Free everything allocated since the last reset. Objects placed in the arena have to be destroyed before.
+   */
+  void reset();
+};
+}; // namespace kleins
+
+#endif
@@ -0,0 +1,339 @@
+#include "requestReader.h"
+
+kleins::requestReader::requestReader(const requestLimits& readerLimits) {
+  limits = readerLimits;
+}
+
+void kleins::requestReader::feed(const char* data, size_t length) {
+  if (consumed > input.length() / 2) {
+    input.erase(0, consumed);
+    consumed = 0;
+  }
+
+  input.append(data, length);
+}
+
+size_t kleins::requestReader::unread() {
+  return input.length() - consumed;
+}
+
+void kleins::requestReader::consume(size_t length) {
+  consumed += length;
+
+  if (consumed == input.length()) {
+    input.clear();
+    consumed = 0;
+  }
+}
+
+bool kleins::requestReader::takeLine(std::string& line) {
+  size_t lineEnd = input.find("\r\n", consumed);
+
+  if (lineEnd == std::string::npos) {
+    return false;
+  }
+
+  line.assign(input, consumed, lineEnd - consumed);
+  consume(lineEnd + 2 - consumed);
+
+  return true;
+}
+
+kleins::requestReader::readState kleins::requestReader::parseHead() {
+  bool chunked = false;
+  bool hasLength = false;
+  size_t contentLength = 0;
+
+  const char* lineBegin = scanner::findLineEnd(head.data(), head.data() + head.length()) + 2;
+  const char* headEnd = head.data() + head.length() - 2;
+
+  while (lineBegin < headEnd) {
+    const char* lineEnd = scanner::findLineEnd(lineBegin, headEnd + 2);
+    const char* colon = scanner::findEither(lineBegin, lineEnd, ':', '\r');
+
+    if (!colon || *colon != ':') {
+      return READ_MALFORMED;
+    }
+
+    size_t keyLength = colon - lineBegin;
+    const char* key = lineBegin;
+    lineBegin = lineEnd + 2;
+
+    // Only the headers that decide how the body is framed are looked at here
+    bool isLength = keyLength == 14 && strncasecmp(key, "content-length", 14) == 0;
+    bool isEncoding = keyLength == 17 && strncasecmp(key, "transfer-encoding", 17) == 0;
+    bool isExpect = keyLength == 6 && strncasecmp(key, "expect", 6) == 0;
+
+    if (!isLength && !isEncoding && !isExpect) {
+      continue;
+    }
+
+    std::string value(colon + 1, lineEnd);
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    value.erase(0, value.find_first_not_of(" \t"));
+    value.erase(value.find_last_not_of(" \t") + 1);
+
+    if (isLength) {
+      if (value.empty() || value.length() > 18 || value.find_first_not_of("0123456789") != std::string::npos) {
+        return READ_MALFORMED;
+      }
+
+      size_t length = std::stoull(value);
+      if (hasLength && length != contentLength) {
+        return READ_MALFORMED;
+      }
+
+      hasLength = true;
+      contentLength = length;
+    } else if (isEncoding) {
+      // Chunked has to be the last coding, otherwise the end of the body can't be found
+      if (value.length() < 7 || value.compare(value.length() - 7, 7, "chunked") != 0) {
+        return READ_MALFORMED;
+      }
+
+      chunked = true;
+    } else if (value == "100-continue") {
+      continueRequested = true;
+    }
+  }
+
+  // A request carrying both could be framed differently by a proxy in front of the server
+  if (chunked && hasLength) {
+    return READ_MALFORMED;
+  }
+
+  if (chunked) {
+    return READ_CHUNK_SIZE;
+  }
+
+  if (contentLength == 0) {
+    continueRequested = false;
+    return READ_COMPLETE;
+  }
+
+  remaining = contentLength;
+
+  return READ_BODY;
+}
+
+kleins::requestReader::readState kleins::requestReader::advance() {
+  std::string line;
+
+  while (true) {
+    switch (state) {
+    case READ_HEAD: {
+      const char* unreadInput = input.data() + consumed;
+      const char* headEndPointer = scanner::findHeadEnd(unreadInput + scanned, unreadInput + unread());
+
+      if (!headEndPointer) {
+        if (unread() > limits.maxHeaderSize) {
+          state = READ_HEAD_TOO_LARGE;
+          break;
+        }
+
+        scanned = unread() < 3 ? 0 : unread() - 3;
+        return state;
+      }
+
+      size_t headEnd = headEndPointer - unreadInput;
+
+      if (headEnd + 4 > limits.maxHeaderSize) {
+        state = READ_HEAD_TOO_LARGE;
+        break;
+      }
+
+      head.assign(input, consumed, headEnd + 4);
+      consume(headEnd + 4);
+      scanned = 0;
+
+      state = parseHead();
+      headReady = state < READ_MALFORMED;
+
+      if (headReady) {
+        return state;
+      }
+      break;
+    }
+
+    case READ_BODY: {
+      if (!streaming && body.length() + remaining > limits.maxBodySize) {
+        state = READ_BODY_TOO_LARGE;
+        break;
+      }
+
+      size_t available = std::min(remaining, unread());
+
+      body.append(input, consumed, available);
+      consume(available);
+      remaining -= available;
+
+      if (remaining > 0) {
+        return state;
+      }
+
+      state = READ_COMPLETE;
+      break;
+    }
+
+    case READ_CHUNK_SIZE: {
+      if (!takeLine(line)) {
+        if (unread() > 1024) {
+          state = READ_MALFORMED;
+          break;
+        }
+        return state;
+      }
+
+      // Chunk extensions after the size are ignored
+      std::string size = line.substr(0, line.find(';'));
+      size.erase(size.find_last_not_of(" \t") + 1);
+
+      if (size.empty() || size.length() > 15 || size.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+        state = READ_MALFORMED;
+        break;
+      }
+
+      remaining = std::stoull(size, 0, 16);
+
+      if (remaining == 0) {
+        state = READ_TRAILERS;
+        break;
+      }
+
+      if (!streaming && body.length() + remaining > limits.maxBodySize) {
+        state = READ_BODY_TOO_LARGE;
+        break;
+      }
+
+      state = READ_CHUNK_DATA;
+      break;
+    }
+
+    case READ_CHUNK_DATA: {
+      size_t available = std::min(remaining, unread());
+
+      body.append(input, consumed, available);
+      consume(available);
+      remaining -= available;
+
+      if (remaining > 0) {
+        return state;
+      }
+
+      state = READ_CHUNK_END;
+      break;
+    }
+
+    case READ_CHUNK_END: {
+      if (unread() < 2) {
+        return state;
+      }
+
+      if (input.compare(consumed, 2, "\r\n") != 0) {
+        state = READ_MALFORMED;
+        break;
+      }
+
+      consume(2);
+      state = READ_CHUNK_SIZE;
+      break;
+    }
+
+    case READ_TRAILERS: {
+      // Trailer fields are read over and dropped, an empty line ends the request
+      if (!takeLine(line)) {
+        if (unread() > limits.maxHeaderSize) {
+          state = READ_HEAD_TOO_LARGE;
+          break;
+        }
+        return state;
+      }
+
+      if (line.empty()) {
+        state = READ_COMPLETE;
+      }
+      break;
+    }
+
+    default:
+      return state;
+    }
+  }
+}
+
+std::unique_ptr<kleins::packet> kleins::requestReader::takeRequest() {
+  packet* request = new packet;
+
+  request->data.reserve(head.length() + body.length());
+  request->data = head;
+  request->data.append(body);
+  request->size = request->data.length();
+
+  reset();
+
+  return std::unique_ptr<packet>(request);
+}
+
+std::string_view kleins::requestReader::takeRequest(requestArena& arena) {
+  char* request = (char*)arena.allocate(head.length() + body.length(), 1);
+
+  memcpy(request, head.data(), head.length());
+  memcpy(request + head.length(), body.data(), body.length());
+
+  std::string_view taken(request, head.length() + body.length());
+
+  reset();
+
+  return taken;
+}
+
+void kleins::requestReader::reset() {
+  head.clear();
+  body.clear();
+
+  // The buffers are reused for the next request, unless a large body made them grow
+  if (body.capacity() > maxRetainedBodySize) {
+    body.shrink_to_fit();
+  }
+
+  remaining = 0;
+  continueRequested = false;
+  headReady = false;
+  streaming = false;
+  state = READ_HEAD;
+}
+
+bool kleins::requestReader::takeHeadReady() {
+  if (!headReady) {
+    return false;
+  }
+
+  headReady = false;
+  return true;
+}
+
+const std::string& kleins::requestReader::getHead() {
+  return head;
+}
+
+void kleins::requestReader::streamBody() {
+  streaming = true;
+}
+
+void kleins::requestReader::takeBody(std::string& chunk) {
+  chunk.clear();
+  chunk.swap(body);
+}
+
+bool kleins::requestReader::takeContinueRequest() {
+  if (!continueRequested) {
+    return false;
+  }
+
+  continueRequested = false;
+  return true;
+}
+
+bool kleins::requestReader::hasPartialRequest() {
+  return state != READ_HEAD || unread() > 0;
+}
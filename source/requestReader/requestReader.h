@@ -0,0 +1,150 @@
+#ifndef REQUESTREADER_H
+#define REQUESTREADER_H
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <strings.h>
+
+#ifndef SINGLE_HEADER
+#include "../packet/packet.h"
+#include "../requestArena/requestArena.h"
+#include "../scanner/scanner.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief Size limits for incoming requests
+ */
+struct requestLimits {
+  /**
+   * @brief The maximum size of the request line and headers together. Bigger requests are answered with a 431.
+   */
+  size_t maxHeaderSize = 64 * 1024;
+
+  /**
+   * @brief The maximum size of a request body, after removing the chunked encoding. Bigger requests are answered with a 413.
+   */
+  size_t maxBodySize = 16 * 1024 * 1024;
+};
+
+/**
+ * @brief Reassembles HTTP requests from the bytes received on a connection.
+ *
+ * The reader keeps its state between reads, so requests may arrive in any amount of pieces and several of them in one piece.
+ * Bodies are collected according to Content-Length or Transfer-Encoding: chunked, chunked bodies are decoded on the way.
+ * Input is only held until it has been moved into the request it belongs to.
+ */
+class requestReader {
+public:
+  typedef enum readState {
+    READ_HEAD,
+    READ_BODY,
+    READ_CHUNK_SIZE,
+    READ_CHUNK_DATA,
+    READ_CHUNK_END,
+    READ_TRAILERS,
+    READ_COMPLETE,
+    READ_MALFORMED,
+    READ_HEAD_TOO_LARGE,
+    READ_BODY_TOO_LARGE,
+  } readState;
+
+private:
+  requestLimits limits;
+
+  std::string input;
+  readState state = READ_HEAD;
+
+  // The bytes at the start of input that were already read. They are only erased once they make up more than half of it,
+  // so each received byte is moved a bounded number of times instead of once for every line or piece taken off the front.
+  size_t consumed = 0;
+
+  // How far the unread input was already searched for the end of the head
+  size_t scanned = 0;
+
+  std::string head;
+  std::string body;
+
+  // Bodies up to this size leave their buffer to the next request
+  static const size_t maxRetainedBodySize = 64 * 1024;
+
+  size_t remaining = 0;
+  bool continueRequested = false;
+
+  bool headReady = false;
+  bool streaming = false;
+
+  readState parseHead();
+  bool takeLine(std::string& line);
+  size_t unread();
+  void consume(size_t length);
+
+public:
+  requestReader(const requestLimits& readerLimits = requestLimits());
+
+  /**
+   * @brief Add received bytes
+   */
+  void feed(const char* data, size_t length);
+
+  /**
+   * @brief Parse as far as the received bytes allow
+   *
+   * @return READ_COMPLETE once a whole request was read, one of the error states if the request can't be read, otherwise the state it stopped in
+   */
+  readState advance();
+
+  /**
+   * @brief Hand out the request that was just completed and start reading the next one
+   *
+   * @return The head of the request followed by its body, with any chunked encoding removed
+   */
+  std::unique_ptr<packet> takeRequest();
+
+  /**
+   * @brief Like takeRequest, but copies the request into an arena instead of allocating a packet for it
+   */
+  std::string_view takeRequest(requestArena& arena);
+
+  /**
+   * @brief Whether the head of a new request was read since the last call. advance() returns right after reading a head,
+   * before the body limit is checked, so the caller can switch the request to streaming first.
+   */
+  bool takeHeadReady();
+
+  /**
+   * @brief The request line and headers of the current request
+   */
+  const std::string& getHead();
+
+  /**
+   * @brief Stop collecting the body of the current request, it is handed out piece by piece through takeBody instead and maxBodySize doesn't apply to it
+   */
+  void streamBody();
+
+  /**
+   * @brief Move the body read so far out of the reader. Meant for streamed requests.
+   */
+  void takeBody(std::string& chunk);
+
+  /**
+   * @brief Drop what was read of the current request and start reading the next one
+   */
+  void reset();
+
+  /**
+   * @brief Whether the current request asked for a 100 Continue before sending its body. Only true once per request.
+   */
+  bool takeContinueRequest();
+
+  /**
+   * @brief Whether part of a request was received, but not all of it yet
+   */
+  bool hasPartialRequest();
+};
+}; // namespace kleins
+
+#endif
@@ -0,0 +1,191 @@
+#include "responseBuilder.h"
+
+kleins::responseBuilder::responseBuilder(std::pmr::memory_resource* bufferMemory, size_t expectedSize) : memory(bufferMemory) {
+  reserve(expectedSize);
+}
+
+kleins::responseBuilder::~responseBuilder() {
+  if (buffer) {
+    memory->deallocate(buffer, capacity, 1);
+  }
+}
+
+void kleins::responseBuilder::reserve(size_t size) {
+  if (size <= capacity) {
+    return;
+  }
+
+  size_t newCapacity = std::max(size, capacity * 2);
+  char* newBuffer = (char*)memory->allocate(newCapacity, 1);
+
+  if (buffer) {
+    memcpy(newBuffer, buffer, used);
+    memory->deallocate(buffer, capacity, 1);
+  }
+
+  buffer = newBuffer;
+  capacity = newCapacity;
+}
+
+void kleins::responseBuilder::status(std::string_view status) {
+  unsigned int code = 0;
+  auto result = std::from_chars(status.data(), status.data() + status.length(), code);
+
+  if (result.ec == std::errc() && result.ptr == status.data() + status.length() && status.length() == 3) {
+    std::string_view line = statusLine(code);
+
+    if (!line.empty()) {
+      append(line);
+      return;
+    }
+  }
+
+  append("HTTP/1.1 ");
+  append(status);
+  append("\r\n");
+}
+
+void kleins::responseBuilder::status(unsigned int code) {
+  std::string_view line = statusLine(code);
+
+  if (!line.empty()) {
+    append(line);
+    return;
+  }
+
+  char digits[16];
+  auto result = std::to_chars(digits, digits + sizeof(digits), code);
+
+  append("HTTP/1.1 ");
+  append(digits, result.ptr - digits);
+  append("\r\n");
+}
+
+void kleins::responseBuilder::header(std::string_view line) {
+  append(line);
+  append("\r\n");
+}
+
+void kleins::responseBuilder::header(std::string_view name, std::string_view value) {
+  append(name);
+  append(": ");
+  append(value);
+  append("\r\n");
+}
+
+void kleins::responseBuilder::contentLength(size_t length) {
+  char digits[24];
+  auto result = std::to_chars(digits, digits + sizeof(digits), length);
+
+  append("Content-Length: ");
+  append(digits, result.ptr - digits);
+  append("\r\n");
+}
+
+void kleins::responseBuilder::contentType(std::string_view mimeType) {
+  append("Content-Type: ");
+  append(mimeType);
+  append("; charset=utf-8\r\n");
+}
+
+void kleins::responseBuilder::date() {
+  append(dateLine());
+}
+
+void kleins::responseBuilder::server() {
+  append("Server: kleinsHTTP\r\n");
+}
+
+void kleins::responseBuilder::endHead() {
+  append("\r\n");
+}
+
+void kleins::responseBuilder::append(const char* data, size_t length) {
+  if (used + length > capacity) {
+    reserve(used + length);
+  }
+
+  memcpy(buffer + used, data, length);
+  used += length;
+}
+
+void kleins::responseBuilder::append(std::string_view data) {
+  append(data.data(), data.length());
+}
+
+const char* kleins::responseBuilder::data() const {
+  return buffer;
+}
+
+size_t kleins::responseBuilder::length() const {
+  return used;
+}
+
+void kleins::responseBuilder::clear() {
+  used = 0;
+}
+
+std::string_view kleins::responseBuilder::statusLine(unsigned int code) {
+  switch (code) {
+  case 100: return "HTTP/1.1 100 Continue\r\n";
+  case 101: return "HTTP/1.1 101 Switching Protocols\r\n";
+  case 200: return "HTTP/1.1 200 OK\r\n";
+  case 201: return "HTTP/1.1 201 Created\r\n";
+  case 202: return "HTTP/1.1 202 Accepted\r\n";
+  case 204: return "HTTP/1.1 204 No Content\r\n";
+  case 206: return "HTTP/1.1 206 Partial Content\r\n";
+  case 301: return "HTTP/1.1 301 Moved Permanently\r\n";
+  case 302: return "HTTP/1.1 302 Found\r\n";
+  case 303: return "HTTP/1.1 303 See Other\r\n";
+  case 304: return "HTTP/1.1 304 Not Modified\r\n";
+  case 307: return "HTTP/1.1 307 Temporary Redirect\r\n";
+  case 308: return "HTTP/1.1 308 Permanent Redirect\r\n";
+  case 400: return "HTTP/1.1 400 Bad Request\r\n";
+  case 401: return "HTTP/1.1 401 Unauthorized\r\n";
+  case 403: return "HTTP/1.1 403 Forbidden\r\n";
+  case 404: return "HTTP/1.1 404 Not Found\r\n";
+  case 405: return "HTTP/1.1 405 Method Not Allowed\r\n";
+  case 406: return "HTTP/1.1 406 Not Acceptable\r\n";
+  case 408: return "HTTP/1.1 408 Request Timeout\r\n";
+  case 409: return "HTTP/1.1 409 Conflict\r\n";
+  case 410: return "HTTP/1.1 410 Gone\r\n";
+  case 411: return "HTTP/1.1 411 Length Required\r\n";
+  case 412: return "HTTP/1.1 412 Precondition Failed\r\n";
+  case 413: return "HTTP/1.1 413 Content Too Large\r\n";
+  case 414: return "HTTP/1.1 414 URI Too Long\r\n";
+  case 415: return "HTTP/1.1 415 Unsupported Media Type\r\n";
+  case 416: return "HTTP/1.1 416 Range Not Satisfiable\r\n";
+  case 417: return "HTTP/1.1 417 Expectation Failed\r\n";
+  case 422: return "HTTP/1.1 422 Unprocessable Content\r\n";
+  case 426: return "HTTP/1.1 426 Upgrade Required\r\n";
+  case 428: return "HTTP/1.1 428 Precondition Required\r\n";
+  case 429: return "HTTP/1.1 429 Too Many Requests\r\n";
+  case 431: return "HTTP/1.1 431 Request Header Fields Too Large\r\n";
+  case 500: return "HTTP/1.1 500 Internal Server Error\r\n";
+  case 501: return "HTTP/1.1 501 Not Implemented\r\n";
+  case 502: return "HTTP/1.1 502 Bad Gateway\r\n";
+  case 503: return "HTTP/1.1 503 Service Unavailable\r\n";
+  case 504: return "HTTP/1.1 504 Gateway Timeout\r\n";
+  case 505: return "HTTP/1.1 505 HTTP Version Not Supported\r\n";
+  default: return std::string_view();
+  }
+}
+
+std::string_view kleins::responseBuilder::dateLine() {
+  // Every thread keeps its own copy, so there is nothing to lock and no line can be read while it's rewritten
+  thread_local time_t formattedSecond = -1;
+  thread_local char line[64];
+  thread_local size_t lineLength = 0;
+
+  time_t now = time(0);
+
+  if (now != formattedSecond) {
+    struct tm nowTime;
+    gmtime_r(&now, &nowTime);
+
+    lineLength = strftime(line, sizeof(line), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &nowTime);
+    formattedSecond = now;
+  }
+
+  return std::string_view(line, lineLength);
+}
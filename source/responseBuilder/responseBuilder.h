@@ -0,0 +1,92 @@
+#ifndef RESPONSEBUILDER_H
+#define RESPONSEBUILDER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace kleins {
+
+/**
+ * @brief Writes the bytes of a response into one buffer.
+ *
+ * Status lines of known status codes, the Server header and the other fixed lines are stored preformatted and only copied.
+ * The Date header is formatted at most once per second on every thread. Numbers are written without going through streams,
+ * so building a response doesn't allocate as long as the buffer comes from memory that is already there, like a requestArena.
+ */
+class responseBuilder {
+private:
+  std::pmr::memory_resource* memory;
+
+  char* buffer = 0;
+  size_t used = 0;
+  size_t capacity = 0;
+
+  void reserve(size_t size);
+
+public:
+  /**
+   * @param memory Where the buffer is allocated from
+   * @param expectedSize The size to reserve up front, so the buffer doesn't have to grow
+   */
+  responseBuilder(std::pmr::memory_resource* bufferMemory = std::pmr::get_default_resource(), size_t expectedSize = 512);
+  ~responseBuilder();
+
+  responseBuilder(const responseBuilder&) = delete;
+  responseBuilder& operator=(const responseBuilder&) = delete;
+
+  /**
+   * @brief Write the status line. A status that is just a known code gets the matching reason phrase, anything else is written as it is.
+   */
+  void status(std::string_view status);
+  void status(unsigned int code);
+
+  /**
+   * @brief Add a complete header line, without its line ending
+   */
+  void header(std::string_view line);
+  void header(std::string_view name, std::string_view value);
+
+  void contentLength(size_t length);
+
+  /**
+   * @brief Add the Content-Type header for a mime type, with the utf-8 charset
+   */
+  void contentType(std::string_view mimeType);
+
+  void date();
+  void server();
+
+  /**
+   * @brief End the head with an empty line
+   */
+  void endHead();
+
+  /**
+   * @brief Add raw bytes, e.g. the body
+   */
+  void append(const char* data, size_t length);
+  void append(std::string_view data);
+
+  const char* data() const;
+  size_t length() const;
+
+  void clear();
+
+  /**
+   * @brief The preformatted status line of a code including its line ending. Empty for codes without one.
+   */
+  static std::string_view statusLine(unsigned int code);
+
+  /**
+   * @brief The Date header line for the current second including its line ending, formatted once per second and thread
+   */
+  static std::string_view dateLine();
+};
+}; // namespace kleins
+
+#endif
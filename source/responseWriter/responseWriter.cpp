@@ -0,0 +1,77 @@
+#include "responseWriter.h"
+
+kleins::responseWriter::responseWriter(connectionBase* conn, bool useChunks) {
+  connsocket = conn;
+  chunked = useChunks;
+}
+
+kleins::responseWriter::~responseWriter() {
+  if (!ended) {
+    end();
+  }
+}
+
+void kleins::responseWriter::write(const char* data, size_t length) {
+  if (ended) {
+    return;
+  }
+
+  buffer.append(data, length);
+
+  if (buffer.length() >= chunkSize) {
+    flush();
+  }
+}
+
+void kleins::responseWriter::flush() {
+  // An empty chunk would end the body
+  if (buffer.empty()) {
+    return;
+  }
+
+  if (chunked) {
+    char sizeLine[24];
+    int sizeLength = snprintf(sizeLine, sizeof(sizeLine), "%zx\r\n", buffer.length());
+
+    buffer.insert(0, sizeLine, sizeLength);
+    buffer.append("\r\n");
+  }
+
+  connsocket->sendData(buffer.c_str(), buffer.length());
+  uncheckedBytes += buffer.length();
+  buffer.clear();
+
+  // Checking costs a round trip to the connection's thread, so it's only done every half budget.
+  // Waiting for the backlog to halve keeps it below the budget until the next check.
+  if (uncheckedBytes >= maxPendingBytes / 2) {
+    connsocket->waitUntilDrained(maxPendingBytes / 2);
+    uncheckedBytes = 0;
+  }
+}
+
+void kleins::responseWriter::write(const std::string& data) {
+  write(data.data(), data.length());
+}
+
+void kleins::responseWriter::end(const std::list<std::string>& trailers) {
+  if (ended) {
+    return;
+  }
+
+  flush();
+  ended = true;
+
+  if (!chunked) {
+    return;
+  }
+
+  std::string lastChunk = "0\r\n";
+
+  for (auto& trailer : trailers) {
+    lastChunk.append(trailer).append("\r\n");
+  }
+
+  lastChunk.append("\r\n");
+
+  connsocket->sendData(lastChunk.c_str(), lastChunk.length());
+}
@@ -0,0 +1,72 @@
+#ifndef RESPONSEWRITER_H
+#define RESPONSEWRITER_H
+
+#include <list>
+#include <string>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief Sends the body of a response piece by piece, obtained from httpParser::respondChunked after the headers went out.
+ *
+ * Writes are collected into chunks of up to chunkSize bytes of a chunked body. Writes from a worker pool thread wait while the client
+ * is more than maxPendingBytes behind, so producing a large response takes constant memory.
+ * Writes on the I/O thread can't wait, there unsent data is buffered.
+ */
+class responseWriter {
+private:
+  connectionBase* connsocket;
+
+  bool chunked;
+  bool ended = false;
+
+  // Small writes are collected into one chunk
+  std::string buffer;
+
+  // Bytes sent since the last time the writer checked how far behind the client is
+  size_t uncheckedBytes = 0;
+
+public:
+  /**
+   * @param conn The connection to write to
+   * @param useChunks Whether to use the chunked encoding. Without it the body ends when the connection is closed, for HTTP/1.0 clients.
+   */
+  responseWriter(connectionBase* conn, bool useChunks = true);
+
+  /**
+   * @brief Ends the response if end() wasn't called
+   */
+  ~responseWriter();
+
+  /**
+   * @brief How far the client may fall behind before writes wait for it
+   */
+  size_t maxPendingBytes = 256 * 1024;
+
+  /**
+   * @brief Writes are held back until this many bytes came together, unless flush() is called
+   */
+  size_t chunkSize = 16 * 1024;
+
+  void write(const char* data, size_t length);
+  void write(const std::string& data);
+
+  /**
+   * @brief Send everything written so far right away
+   */
+  void flush();
+
+  /**
+   * @brief Finish the response
+   *
+   * @param trailers Header lines sent after the body ("Name: value"). They should be announced in a Trailer header of the response.
+   */
+  void end(const std::list<std::string>& trailers = {});
+};
+}; // namespace kleins
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef ROUTETABLE_H
+#define ROUTETABLE_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#ifndef SINGLE_HEADER
+#include "../router/router.h"
+#endif
+
+namespace kleins {
+
+class httpParser;
+
+/**
+ * @brief An endpoint of a routeTable. The handler is any callable taking an httpParser*, it is stored and called by its own type.
+ */
+template <class handler>
+struct staticRoute {
+  httpMethod method;
+  std::string_view path;
+  handler callback;
+
+  constexpr staticRoute(httpMethod routeMethod, std::string_view routePath, handler routeCallback)
+      : method(routeMethod), path(routePath), callback(routeCallback) {
+  }
+};
+
+/**
+ * @brief Calls a function given as template parameter, so routes to plain functions are direct calls as well
+ *
+ * \code{.cpp}
+ * kleins::staticRoute(kleins::GET, "/hello", kleins::routeHandler<hello>())
+ * \endcode
+ */
+template <auto function>
+struct routeHandler {
+  constexpr void operator()(httpParser* parser) const {
+    function(parser);
+  }
+};
+
+/**
+ * @brief A fixed set of endpoints whose lookup table is built by the compiler.
+ *
+ * The method and path of every route are hashed into an open addressed table when the routeTable is constructed, in a constant expression
+ * if it's declared constexpr. A request is then dispatched with one hash of its method and path and a call of the handler by its own type,
+ * which the compiler can inline. Paths are matched exactly, routes with parameters belong in httpServer::on.
+ * When a method and path are listed more than once the first route is used.
+ *
+ * \code{.cpp}
+ * constexpr auto routes = kleins::makeRouteTable(
+ *     kleins::staticRoute(kleins::GET, "/", [](kleins::httpParser* parser) { parser->respond("200", {}, "Hello!"); }),
+ *     kleins::staticRoute(kleins::GET, "/hi", kleins::routeHandler<sayHi>()));
+ *
+ * server.on(routes);
+ * \endcode
+ */
+template <class... handlers>
+class routeTable {
+public:
+  static constexpr size_t routeCount = sizeof...(handlers);
+
+private:
+  // At most half of the slots are used, which keeps probe sequences short
+  static constexpr size_t slotCount() {
+    size_t count = 1;
+    while (count < routeCount * 2) {
+      count *= 2;
+    }
+    return count;
+  }
+
+  std::tuple<handlers...> callbacks;
+  std::array<std::string_view, routeCount> methods;
+  std::array<std::string_view, routeCount> paths;
+  std::array<uint64_t, routeCount> hashes;
+
+  // The index of the route stored in each slot plus one, 0 for empty slots
+  std::array<size_t, slotCount()> slots;
+
+  template <size_t... indices>
+  void call(size_t index, httpParser* parser, std::index_sequence<indices...>) const {
+    ((index == indices ? (std::get<indices>(callbacks)(parser), true) : false) || ...);
+  }
+
+public:
+  /**
+   * @brief The FNV-1a hash routes are stored under
+   */
+  static constexpr uint64_t hash(std::string_view method, std::string_view path) {
+    uint64_t value = 14695981039346656037ull;
+
+    for (char c : method) {
+      value = (value ^ (unsigned char)c) * 1099511628211ull;
+    }
+
+    value = (value ^ ' ') * 1099511628211ull;
+
+    for (char c : path) {
+      value = (value ^ (unsigned char)c) * 1099511628211ull;
+    }
+
+    return value;
+  }
+
+  constexpr routeTable(const staticRoute<handlers>&... routes)
+      : callbacks(routes.callback...), methods{router::methodNames[routes.method]...}, paths{routes.path...}, hashes{}, slots{} {
+    for (size_t i = 0; i < routeCount; i++) {
+      hashes[i] = hash(methods[i], paths[i]);
+
+      size_t slot = hashes[i] & (slotCount() - 1);
+
+      while (slots[slot] != 0) {
+        size_t stored = slots[slot] - 1;
+
+        if (hashes[stored] == hashes[i] && methods[stored] == methods[i] && paths[stored] == paths[i]) {
+          break;
+        }
+
+        slot = (slot + 1) & (slotCount() - 1);
+      }
+
+      if (slots[slot] == 0) {
+        slots[slot] = i + 1;
+      }
+    }
+  }
+
+  /**
+   * @brief Call the handler for a request
+   *
+   * @return false if the table has no route for the method and path
+   */
+  bool dispatch(std::string_view method, std::string_view path, httpParser* parser) const {
+    uint64_t requestHash = hash(method, path);
+
+    for (size_t slot = requestHash & (slotCount() - 1); slots[slot] != 0; slot = (slot + 1) & (slotCount() - 1)) {
+      size_t index = slots[slot] - 1;
+
+      if (hashes[index] == requestHash && methods[index] == method && paths[index] == path) {
+        call(index, parser, std::index_sequence_for<handlers...>());
+        return true;
+      }
+    }
+
+    return false;
+  }
+};
+
+/**
+ * @brief Build a routeTable, the handler types are deduced from the routes
+ */
+template <class... handlers>
+constexpr routeTable<handlers...> makeRouteTable(const staticRoute<handlers>&... routes) {
+  return routeTable<handlers...>(routes...);
+}
+}; // namespace kleins
+
+#endif
@@ -0,0 +1,271 @@
+#include "router.h"
+
+kleins::router::router() : root(0), outdated(true) {
+  // The first tree is the one routes are added to, lookups only see copies of it
+  trees.push_back(std::unique_ptr<node>(new node));
+}
+
+kleins::router::~router() {
+}
+
+std::unique_ptr<kleins::router::node> kleins::router::copyTree(const node* tree) {
+  std::unique_ptr<node> copy(new node);
+
+  copy->prefix = tree->prefix;
+  copy->indices = tree->indices;
+
+  for (auto& child : tree->children) {
+    copy->children.push_back(copyTree(child.get()));
+  }
+
+  if (tree->parameterChild) {
+    copy->parameterChild = copyTree(tree->parameterChild.get());
+    copy->parameterName = tree->parameterName;
+  }
+
+  if (tree->wildcardChild) {
+    copy->wildcardChild = copyTree(tree->wildcardChild.get());
+    copy->wildcardName = tree->wildcardName;
+  }
+
+  std::copy(std::begin(tree->routes), std::end(tree->routes), std::begin(copy->routes));
+
+  return copy;
+}
+
+bool kleins::router::add(
+    httpMethod method, const std::string& pattern, const std::function<void(httpParser*)> handler, bool streamed, bool patterns) {
+  std::lock_guard<std::mutex> lock(buildMutex);
+
+  route newRoute;
+  newRoute.method = method;
+  newRoute.pattern = pattern;
+  newRoute.handler = handler;
+  newRoute.streamed = streamed;
+
+  routes.push_back(newRoute);
+
+  // Routes are inserted into the first tree, which is never looked up. Lookups get a copy of it.
+  if (!insert(trees.front().get(), &routes.back(), patterns)) {
+    routes.pop_back();
+    return false;
+  }
+
+  outdated.store(true, std::memory_order_release);
+  return true;
+}
+
+bool kleins::router::insert(node* tree, const route* newRoute, bool patterns) {
+  const std::string& pattern = newRoute->pattern;
+  size_t parameterCount = 0;
+
+  // Only segments starting with ':' or '*' are parameters, anywhere else those characters are matched like any other
+  auto segmentStart = [&pattern, patterns](size_t position) {
+    return patterns && (pattern[position] == ':' || pattern[position] == '*') && (position == 0 || pattern[position - 1] == '/');
+  };
+
+  for (size_t position = 0; position < pattern.length(); position++) {
+    if (!segmentStart(position)) {
+      continue;
+    }
+
+    size_t nameEnd = std::min(pattern.find('/', position), pattern.length());
+
+    if (pattern[position] == ':' && nameEnd == position + 1) {
+      std::cerr << "Error adding route " << pattern << ": parameters need a name" << std::endl;
+      return false;
+    }
+
+    if (pattern[position] == '*' && nameEnd != pattern.length()) {
+      std::cerr << "Error adding route " << pattern << ": a wildcard has to be the last segment" << std::endl;
+      return false;
+    }
+
+    if (++parameterCount > maxParameters) {
+      std::cerr << "Error adding route " << pattern << ": more than " << maxParameters << " parameters" << std::endl;
+      return false;
+    }
+  }
+
+  node* current = tree;
+  size_t position = 0;
+
+  while (position < pattern.length()) {
+    if (segmentStart(position) && pattern[position] == ':') {
+      size_t nameEnd = std::min(pattern.find('/', position), pattern.length());
+      std::string name = pattern.substr(position + 1, nameEnd - position - 1);
+
+      if (!current->parameterChild) {
+        current->parameterChild.reset(new node);
+        current->parameterName = name;
+      } else if (current->parameterName != name) {
+        std::cerr << "Error adding route " << pattern << ": the parameter :" << name << " conflicts with :" << current->parameterName << std::endl;
+        return false;
+      }
+
+      current = current->parameterChild.get();
+      position = nameEnd;
+      continue;
+    }
+
+    if (segmentStart(position) && pattern[position] == '*') {
+      std::string name = pattern.substr(position + 1);
+      if (name.empty()) {
+        name = "*";
+      }
+
+      if (!current->wildcardChild) {
+        current->wildcardChild.reset(new node);
+        current->wildcardName = name;
+      } else if (current->wildcardName != name) {
+        std::cerr << "Error adding route " << pattern << ": the wildcard *" << name << " conflicts with *" << current->wildcardName << std::endl;
+        return false;
+      }
+
+      current = current->wildcardChild.get();
+      break;
+    }
+
+    size_t textEnd = position + 1;
+    while (textEnd < pattern.length() && !segmentStart(textEnd)) {
+      textEnd++;
+    }
+
+    std::string_view text(pattern.data() + position, textEnd - position);
+    size_t index = current->indices.find(text[0]);
+
+    if (index == std::string::npos) {
+      current->indices.push_back(text[0]);
+      current->children.push_back(std::unique_ptr<node>(new node));
+      current->children.back()->prefix = std::string(text);
+
+      current = current->children.back().get();
+      position = textEnd;
+      continue;
+    }
+
+    node* child = current->children[index].get();
+
+    size_t common = 0;
+    while (common < text.length() && common < child->prefix.length() && text[common] == child->prefix[common]) {
+      common++;
+    }
+
+    // Split the child where the new route branches off
+    if (common < child->prefix.length()) {
+      std::unique_ptr<node> middle(new node);
+      middle->prefix = child->prefix.substr(0, common);
+
+      child->prefix.erase(0, common);
+      middle->indices.push_back(child->prefix[0]);
+      middle->children.push_back(std::move(current->children[index]));
+
+      current->children[index] = std::move(middle);
+      child = current->children[index].get();
+    }
+
+    current = child;
+    position += common;
+  }
+
+  if (!current->routes[newRoute->method]) {
+    current->routes[newRoute->method] = newRoute;
+  }
+
+  return true;
+}
+
+void kleins::router::rebuild() {
+  std::lock_guard<std::mutex> lock(buildMutex);
+
+  if (!outdated.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  trees.push_back(copyTree(trees.front().get()));
+  root.store(trees.back().get(), std::memory_order_release);
+
+  outdated.store(false, std::memory_order_release);
+}
+
+const kleins::router::route* kleins::router::find(std::string_view method, std::string_view path, routeMatch& result) {
+  if (outdated.load(std::memory_order_acquire)) {
+    rebuild();
+  }
+
+  result.matched = 0;
+  result.parameterCount = 0;
+
+  httpMethod requestMethod;
+  if (!parseMethod(method, requestMethod)) {
+    return 0;
+  }
+
+  if (!match(root.load(std::memory_order_acquire), path, requestMethod, result)) {
+    result.matched = 0;
+    result.parameterCount = 0;
+  }
+
+  return result.matched;
+}
+
+bool kleins::router::parseMethod(std::string_view name, httpMethod& method) {
+  for (size_t i = 0; i < methodCount; i++) {
+    if (name == methodNames[i]) {
+      method = (httpMethod)i;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const char* kleins::router::methodName(httpMethod method) {
+  return methodNames[method];
+}
+
+bool kleins::router::match(const node* current, std::string_view path, httpMethod method, routeMatch& result) const {
+  if (path.empty()) {
+    if (current->routes[method]) {
+      result.matched = current->routes[method];
+      return true;
+    }
+  } else {
+    size_t index = current->indices.find(path[0]);
+
+    if (index != std::string::npos) {
+      const node* child = current->children[index].get();
+
+      if (path.compare(0, child->prefix.length(), child->prefix) == 0 && match(child, path.substr(child->prefix.length()), method, result)) {
+        return true;
+      }
+    }
+
+    if (current->parameterChild && result.parameterCount < maxParameters) {
+      size_t segmentEnd = std::min(path.find('/'), path.length());
+
+      if (segmentEnd > 0) {
+        result.parameterNames[result.parameterCount] = current->parameterName;
+        result.parameterValues[result.parameterCount] = path.substr(0, segmentEnd);
+        result.parameterCount++;
+
+        if (match(current->parameterChild.get(), path.substr(segmentEnd), method, result)) {
+          return true;
+        }
+
+        result.parameterCount--;
+      }
+    }
+  }
+
+  if (current->wildcardChild && current->wildcardChild->routes[method] && result.parameterCount < maxParameters) {
+    result.parameterNames[result.parameterCount] = current->wildcardName;
+    result.parameterValues[result.parameterCount] = path;
+    result.parameterCount++;
+
+    result.matched = current->wildcardChild->routes[method];
+    return true;
+  }
+
+  return false;
+}
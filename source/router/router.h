@@ -0,0 +1,128 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kleins {
+
+class httpParser;
+
+typedef enum httpMethod { GET, HEAD, POST, PUT, DELETE, CONNECT, OPTIONS, TRACE, PATCH } httpMethod;
+
+/**
+ * @brief Maps the method and path of a request to its endpoint, using a compressed radix tree.
+ *
+ * Patterns are matched segment by segment. A segment starting with ':' matches any single segment and a trailing segment starting with '*'
+ * matches the rest of the path, both make the matched text available under the name following the ':' or '*'.
+ * Static segments take precedence over parameters, and parameters over wildcards.
+ *
+ * Lookups don't allocate or lock. The tree is rebuilt once on the first lookup after routes were added and then shared by all threads,
+ * replaced trees are kept until the router is destroyed because lookups may still be walking them.
+ */
+class router {
+public:
+  static const size_t methodCount = PATCH + 1;
+
+  // The names of the methods by httpMethod, shared with routeTable so both match the same methods
+  static constexpr const char* methodNames[methodCount] = {"GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"};
+  static const size_t maxParameters = 8;
+
+  /**
+   * @brief An endpoint as it was added
+   */
+  struct route {
+    httpMethod method;
+    std::string pattern;
+    std::function<void(httpParser*)> handler;
+
+    // Whether the endpoint receives the body as it arrives, see httpServer::onStream
+    bool streamed = false;
+  };
+
+  /**
+   * @brief The result of a lookup. The parameters point into the looked up path and the pattern of the route.
+   */
+  struct routeMatch {
+    const route* matched = 0;
+
+    size_t parameterCount = 0;
+    std::string_view parameterNames[maxParameters];
+    std::string_view parameterValues[maxParameters];
+  };
+
+private:
+  struct node {
+    // The static text leading to this node from its parent
+    std::string prefix;
+
+    // The first characters of the static children, in the same order as children
+    std::string indices;
+    std::vector<std::unique_ptr<node>> children;
+
+    std::unique_ptr<node> parameterChild;
+    std::string parameterName;
+
+    std::unique_ptr<node> wildcardChild;
+    std::string wildcardName;
+
+    const route* routes[methodCount] = {};
+  };
+
+  // Every route ever added, the trees point into it. A list keeps them in place while more are added.
+  std::list<route> routes;
+
+  std::list<std::unique_ptr<node>> trees;
+  std::atomic<node*> root;
+  std::atomic<bool> outdated;
+
+  std::mutex buildMutex;
+
+  static std::unique_ptr<node> copyTree(const node* tree);
+
+  void rebuild();
+  bool insert(node* tree, const route* newRoute, bool patterns);
+  bool match(const node* current, std::string_view path, httpMethod method, routeMatch& result) const;
+
+public:
+  router();
+  ~router();
+
+  /**
+   * @brief Add an endpoint. Routes that were added before for the same method and pattern take precedence. May be called while serving.
+   *
+   * @param pattern The path to match, e.g. "/users/:id", a last segment like "*file" matches the rest of the path
+   * @param patterns Whether ':' and '*' segments are parameters, otherwise the pattern is matched literally
+   * @return false if the pattern is invalid
+   */
+  bool add(httpMethod method, const std::string& pattern, const std::function<void(httpParser*)> handler, bool streamed = false, bool patterns = true);
+
+  /**
+   * @brief Look up the endpoint for a request
+   *
+   * @return The matched route, 0 if there is none for this method and path
+   */
+  const route* find(std::string_view method, std::string_view path, routeMatch& result);
+
+  /**
+   * @brief Convert the name of a method as sent in a request
+   *
+   * @return false for unknown methods
+   */
+  static bool parseMethod(std::string_view name, httpMethod& method);
+
+  /**
+   * @brief The name of a method as sent in a request
+   */
+  static const char* methodName(httpMethod method);
+};
+}; // namespace kleins
+
+#endif
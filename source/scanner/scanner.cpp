@@ -0,0 +1,194 @@
+#include "scanner.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCANNER_X86
+#endif
+
+namespace {
+
+const char* findHeadEndScalar(const char* begin, const char* end) {
+  for (const char* p = begin; p + 3 < end; p++) {
+    if (p[0] == '\r' && p[1] == '\n' && p[2] == '\r' && p[3] == '\n') {
+      return p;
+    }
+  }
+
+  return 0;
+}
+
+const char* findEitherScalar(const char* begin, const char* end, char first, char second) {
+  for (const char* p = begin; p < end; p++) {
+    if (*p == first || *p == second) {
+      return p;
+    }
+  }
+
+  return 0;
+}
+
+#ifdef SCANNER_X86
+
+// The 16 byte searches are built twice, once for SSE4.2 cpus and once in the VEX encoding for the AVX2 level.
+// Mixing legacy SSE instructions into AVX2 code costs a state transition on every switch.
+// The head search compares four shifted loads instead of one, a match is the first byte of a complete "\r\n\r\n" even across block borders.
+#define SCANNER_16_BYTE_SEARCHES(TARGET, SUFFIX)                                                                                                     \
+  __attribute__((target(TARGET))) const char* findHeadEnd##SUFFIX(const char* begin, const char* end) {                                              \
+    const __m128i cr = _mm_set1_epi8('\r');                                                                                                           \
+    const __m128i lf = _mm_set1_epi8('\n');                                                                                                           \
+                                                                                                                                                      \
+    const char* p = begin;                                                                                                                            \
+    for (; end - p >= 16 + 3; p += 16) {                                                                                                              \
+      __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), cr);                                                                         \
+      __m128i second = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 1)), lf);                                                                  \
+      __m128i third = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 2)), cr);                                                                   \
+      __m128i fourth = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 3)), lf);                                                                  \
+                                                                                                                                                      \
+      int mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(first, second), _mm_and_si128(third, fourth)));                                        \
+      if (mask != 0) {                                                                                                                                \
+        return p + __builtin_ctz(mask);                                                                                                               \
+      }                                                                                                                                               \
+    }                                                                                                                                                 \
+                                                                                                                                                      \
+    return findHeadEndScalar(p, end);                                                                                                                 \
+  }                                                                                                                                                   \
+                                                                                                                                                      \
+  __attribute__((target(TARGET))) const char* findEither##SUFFIX(const char* begin, const char* end, char first, char second) {                     \
+    const __m128i set = _mm_setr_epi8(first, second, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);                                                      \
+                                                                                                                                                      \
+    const char* p = begin;                                                                                                                            \
+    for (; end - p >= 16; p += 16) {                                                                                                                  \
+      int index = _mm_cmpestri(set, 2, _mm_loadu_si128((const __m128i*)p), 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY);                              \
+      if (index != 16) {                                                                                                                              \
+        return p + index;                                                                                                                             \
+      }                                                                                                                                               \
+    }                                                                                                                                                 \
+                                                                                                                                                      \
+    return findEitherScalar(p, end, first, second);                                                                                                   \
+  }
+
+SCANNER_16_BYTE_SEARCHES("sse4.2", SSE42)
+SCANNER_16_BYTE_SEARCHES("avx2", VEX)
+
+__attribute__((target("avx2"))) const char* findHeadEndAVX2(const char* begin, const char* end) {
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+
+  const char* p = begin;
+  for (; end - p >= 32 + 3; p += 32) {
+    __m256i first = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), cr);
+    __m256i second = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 1)), lf);
+    __m256i third = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 2)), cr);
+    __m256i fourth = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 3)), lf);
+
+    unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(first, second), _mm256_and_si256(third, fourth)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+
+  return findHeadEndVEX(p, end);
+}
+
+__attribute__((target("avx2"))) const char* findEitherAVX2(const char* begin, const char* end, char first, char second) {
+  // Most header names are shorter than a block, they are cheaper to search 16 bytes at a time
+  if (end - begin < 64) {
+    return findEitherVEX(begin, end, first, second);
+  }
+
+  const __m256i firstSet = _mm256_set1_epi8(first);
+  const __m256i secondSet = _mm256_set1_epi8(second);
+
+  const char* p = begin;
+  for (; end - p >= 32; p += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i*)p);
+    __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(block, firstSet), _mm256_cmpeq_epi8(block, secondSet));
+
+    unsigned int mask = _mm256_movemask_epi8(matches);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+
+  return findEitherVEX(p, end, first, second);
+}
+
+#endif
+
+} // namespace
+
+// Usable before static initialization ran, the best implementation is picked up right after
+kleins::scanner::headEndFunction kleins::scanner::headEndImplementation = findHeadEndScalar;
+kleins::scanner::eitherFunction kleins::scanner::eitherImplementation = findEitherScalar;
+kleins::scanner::scanLevel kleins::scanner::level = kleins::scanner::SCAN_SCALAR;
+
+static const bool scannerLevelDetected = (kleins::scanner::setLevel(kleins::scanner::detectLevel()), true);
+
+kleins::scanner::scanLevel kleins::scanner::detectLevel() {
+#ifdef SCANNER_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2")) {
+    return SCAN_AVX2;
+  }
+
+  if (__builtin_cpu_supports("sse4.2")) {
+    return SCAN_SSE42;
+  }
+#endif
+
+  return SCAN_SCALAR;
+}
+
+void kleins::scanner::setLevel(scanLevel newLevel) {
+  if (newLevel > detectLevel()) {
+    newLevel = detectLevel();
+  }
+
+  level = newLevel;
+
+  switch (level) {
+#ifdef SCANNER_X86
+  case SCAN_AVX2:
+    headEndImplementation = findHeadEndAVX2;
+    eitherImplementation = findEitherAVX2;
+    break;
+
+  case SCAN_SSE42:
+    headEndImplementation = findHeadEndSSE42;
+    eitherImplementation = findEitherSSE42;
+    break;
+#endif
+
+  default:
+    headEndImplementation = findHeadEndScalar;
+    eitherImplementation = findEitherScalar;
+    break;
+  }
+}
+
+kleins::scanner::scanLevel kleins::scanner::getLevel() {
+  return level;
+}
+
+const char* kleins::scanner::findHeadEnd(const char* begin, const char* end) {
+  return headEndImplementation(begin, end);
+}
+
+const char* kleins::scanner::findEither(const char* begin, const char* end, char first, char second) {
+  return eitherImplementation(begin, end, first, second);
+}
+
+const char* kleins::scanner::findLineEnd(const char* begin, const char* end) {
+  const char* p = begin;
+
+  // memchr is vectorized by the C library already
+  while (p < end && (p = (const char*)memchr(p, '\r', end - p)) != 0) {
+    if (p + 1 < end && p[1] == '\n') {
+      return p;
+    }
+    p++;
+  }
+
+  return 0;
+}
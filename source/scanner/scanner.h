@@ -0,0 +1,63 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <cstddef>
+#include <cstring>
+
+namespace kleins {
+
+/**
+ * @brief Delimiter searches used to take requests apart.
+ *
+ * They look at 32 (AVX2) or 16 (SSE4.2) bytes per step, the widest variant the cpu supports is picked when the library is loaded.
+ * A plain byte loop is the fallback for other cpus. All of them return 0 if nothing was found.
+ */
+class scanner {
+public:
+  typedef enum scanLevel {
+    SCAN_SCALAR,
+    SCAN_SSE42,
+    SCAN_AVX2,
+  } scanLevel;
+
+private:
+  typedef const char* (*headEndFunction)(const char* begin, const char* end);
+  typedef const char* (*eitherFunction)(const char* begin, const char* end, char first, char second);
+
+  static headEndFunction headEndImplementation;
+  static eitherFunction eitherImplementation;
+  static scanLevel level;
+
+public:
+  /**
+   * @brief The best level the cpu supports
+   */
+  static scanLevel detectLevel();
+
+  /**
+   * @brief Switch to another implementation, e.g. to compare them. Levels the cpu doesn't support fall back to the next lower one.
+   * Not thread safe, call it before serving.
+   */
+  static void setLevel(scanLevel newLevel);
+  static scanLevel getLevel();
+
+  /**
+   * @brief Find the empty line ending a request head
+   *
+   * @return The "\r\n\r\n" ending the head
+   */
+  static const char* findHeadEnd(const char* begin, const char* end);
+
+  /**
+   * @brief Find the first occurence of either of two characters
+   */
+  static const char* findEither(const char* begin, const char* end, char first, char second);
+
+  /**
+   * @brief Find the "\r\n" ending a line
+   */
+  static const char* findLineEnd(const char* begin, const char* end);
+};
+}; // namespace kleins
+
+#endif
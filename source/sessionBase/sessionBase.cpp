@@ -1,8 +1,29 @@
 #include "sessionBase.h"
 
 kleins::sessionBase::sessionBase(unsigned int timeout) {
-  expireTime = std::chrono::system_clock::now() + std::chrono::minutes(timeout);
+  extend(timeout);
 }
 
 kleins::sessionBase::~sessionBase() {
-}
\ No newline at end of file
+}
+
+void kleins::sessionBase::serialize(std::string& /*data*/) const {
+}
+
+bool kleins::sessionBase::deserialize(std::string_view /*data*/) {
+  return true;
+}
+
+std::chrono::time_point<std::chrono::system_clock> kleins::sessionBase::getExpireTime() const {
+  std::chrono::nanoseconds sinceEpoch(expireTime.load(std::memory_order_relaxed));
+
+  return std::chrono::time_point<std::chrono::system_clock>(std::chrono::duration_cast<std::chrono::system_clock::duration>(sinceEpoch));
+}
+
+void kleins::sessionBase::setExpireTime(std::chrono::time_point<std::chrono::system_clock> time) {
+  expireTime.store(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count(), std::memory_order_relaxed);
+}
+
+void kleins::sessionBase::extend(unsigned int timeout) {
+  setExpireTime(std::chrono::system_clock::now() + std::chrono::minutes(timeout));
+}
@@ -1,10 +1,16 @@
 #ifndef SESSIONBASE_H
 #define SESSIONBASE_H
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace kleins {
+class sessionPoolBase;
+class sessionStore;
+
 /**
  * @brief a base class for storing session data.
  * 
@@ -24,21 +30,75 @@ public:
   /**
      * @brief Destroy the session Base object
      * 
-     * Does nothing
+     * Virtual, as sessions are deleted through this base class once they expired
+     */
+  virtual ~sessionBase();
+
+  /**
+     * @brief Write the data of the session into a session snapshot, see httpServer::setSessionSnapshot
+     * 
+     * @param data Where to append the data
+     * 
+     * Writes nothing unless overridden, sessions are then restored with their key and expireTime only.
+     * It is called while the session may be in use by a request, so guard data that endpoints change.
      */
-  ~sessionBase();
+  virtual void serialize(std::string& data) const;
+
+  /**
+     * @brief Restore the data written by serialize, in a new session of the same class
+     * 
+     * @return false if the data can't be used, a new session is started instead
+     */
+  virtual bool deserialize(std::string_view data);
+
+  static const size_t keyLength = 32;
 
   /**
      * @brief The session key this session uses.
      * 
+     * Points into the session itself, empty until the session is stored.
+     */
+  std::string_view sessionKey;
+
+  /**
+     * @brief Where sessionKey points, the key is kept in the session so storing it doesn't allocate
+     * 
      */
-  const std::string* sessionKey;
+  char keyStorage[keyLength];
+
+  /**
+     * @brief The pool the session was allocated from, 0 if it was created with new
+     * 
+     */
+  sessionPoolBase* pool = 0;
 
   /**
      * @brief The time at which this session expires
      * 
      */
-  std::chrono::time_point<std::chrono::system_clock> expireTime;
+  std::chrono::time_point<std::chrono::system_clock> getExpireTime() const;
+
+  /**
+     * @brief Move the time at which this session expires, e.g. to keep it alive while it's used
+     * 
+     * May be called by endpoints while the sessionStore looks at the session from another thread.
+     */
+  void setExpireTime(std::chrono::time_point<std::chrono::system_clock> time);
+
+  /**
+     * @brief Let the session expire timeout minutes from now
+     * 
+     */
+  void extend(unsigned int timeout);
+
+private:
+  friend class sessionStore;
+
+  // The expiry in nanoseconds since the epoch of the system clock, atomic as endpoints move it while the store reads it
+  std::atomic<int64_t> expireTime;
+
+  // The store and every request using the session hold a reference, the last one to let go destroys it
+  std::atomic<unsigned int> references{0};
 };
 } // namespace kleins
 
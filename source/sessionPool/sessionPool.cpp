@@ -0,0 +1,20 @@
+#include "sessionPool.h"
+
+kleins::sessionPoolBase::~sessionPoolBase() {
+}
+
+unsigned int kleins::sessionPoolBase::threadShard() {
+  static std::atomic<unsigned int> nextShard{0};
+
+  static thread_local unsigned int shard = nextShard.fetch_add(1, std::memory_order_relaxed) % shardCount;
+
+  return shard;
+}
+
+void kleins::sessionPoolBase::destroy(sessionBase* session) {
+  if (session->pool) {
+    session->pool->release(session);
+  } else {
+    delete session;
+  }
+}
@@ -0,0 +1,167 @@
+#ifndef SESSIONPOOL_H
+#define SESSIONPOOL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../sessionBase/sessionBase.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief What the sessionStore returns expired sessions to, whatever class they are
+ */
+class sessionPoolBase {
+public:
+  static const unsigned int shardCount = 16;
+
+  virtual ~sessionPoolBase();
+
+  /**
+   * @brief Destroy a session of this pool and make its memory available to the next one
+   */
+  virtual void release(sessionBase* session) = 0;
+
+  /**
+   * @brief Destroy a session, returning it to its pool or deleting it if it doesn't have one
+   */
+  static void destroy(sessionBase* session);
+
+protected:
+  /**
+   * @brief The shard of the calling thread, threads are spread over the shards round robin
+   */
+  static unsigned int threadShard();
+};
+
+/**
+ * @brief Allocates the sessions of one class from slabs of slots.
+ *
+ * Sessions are placed into the free slots of slabs holding slabCapacity of them, so they sit next to each other instead of all over the heap,
+ * and expired sessions leave their slot to the next one instead of going back to the general purpose allocator.
+ * Free slots are kept in a list per shard of threads, so threads creating and releasing sessions at the same time rarely wait for each other.
+ * A thread whose list ran empty takes over the list of another shard before a new slab is allocated, as sessions are mostly released
+ * by another thread than the one that created them.
+ * Slabs are kept until the pool is destroyed, which has to happen after all of its sessions were released.
+ */
+template <class T>
+class sessionPool : public sessionPoolBase {
+public:
+  static const size_t slabCapacity = 64;
+
+private:
+  union slot {
+    slot* next;
+    alignas(T) unsigned char object[sizeof(T)];
+  };
+
+  struct alignas(64) freeList {
+    std::mutex mutex;
+
+    // Chained through the next pointer of the free slots
+    slot* slots = 0;
+  };
+
+  freeList freeLists[shardCount];
+
+  std::mutex slabMutex;
+  std::vector<std::unique_ptr<slot[]>> slabs;
+
+  // Take the free slots of another shard. Shards that are locked right now are skipped, waiting for them could deadlock with their thread stealing back.
+  slot* stealSlots(unsigned int shard) {
+    for (unsigned int i = 1; i < shardCount; i++) {
+      freeList& other = freeLists[(shard + i) % shardCount];
+      std::unique_lock<std::mutex> lock(other.mutex, std::try_to_lock);
+
+      if (lock.owns_lock() && other.slots) {
+        slot* stolen = other.slots;
+        other.slots = 0;
+        return stolen;
+      }
+    }
+
+    return 0;
+  }
+
+  slot* newSlab() {
+    std::lock_guard<std::mutex> lock(slabMutex);
+
+    slabs.emplace_back(new slot[slabCapacity]);
+    slot* slab = slabs.back().get();
+
+    for (size_t i = 0; i < slabCapacity; i++) {
+      slab[i].next = i + 1 < slabCapacity ? &slab[i + 1] : 0;
+    }
+
+    return slab;
+  }
+
+  slot* takeSlot() {
+    unsigned int shard = threadShard();
+    freeList& own = freeLists[shard];
+
+    std::lock_guard<std::mutex> lock(own.mutex);
+
+    if (!own.slots) {
+      own.slots = stealSlots(shard);
+    }
+
+    if (!own.slots) {
+      own.slots = newSlab();
+    }
+
+    slot* taken = own.slots;
+    own.slots = taken->next;
+
+    return taken;
+  }
+
+  void returnSlot(slot* freed) {
+    freeList& own = freeLists[threadShard()];
+
+    std::lock_guard<std::mutex> lock(own.mutex);
+
+    freed->next = own.slots;
+    own.slots = freed;
+  }
+
+public:
+  sessionPool() {
+  }
+
+  sessionPool(const sessionPool&) = delete;
+  sessionPool& operator=(const sessionPool&) = delete;
+
+  /**
+   * @brief Construct a session in a free slot
+   */
+  T* create() {
+    slot* free = takeSlot();
+    T* session;
+
+    try {
+      session = new (free->object) T();
+    } catch (...) {
+      returnSlot(free);
+      throw;
+    }
+
+    session->pool = this;
+    return session;
+  }
+
+  void release(sessionBase* session) override {
+    T* object = static_cast<T*>(session);
+    object->~T();
+
+    returnSlot(reinterpret_cast<slot*>(object));
+  }
+};
+}; // namespace kleins
+
+#endif
@@ -0,0 +1,232 @@
+#include "sessionSnapshot.h"
+
+kleins::sessionSnapshot::sessionSnapshot(const std::string& filePath) {
+  path = filePath;
+
+  map();
+}
+
+kleins::sessionSnapshot::~sessionSnapshot() {
+  if (mapping) {
+    munmap((void*)mapping, mappingSize);
+  }
+}
+
+bool kleins::sessionSnapshot::map() {
+  int filefd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+  // No snapshot was written yet
+  if (filefd < 0) {
+    return false;
+  }
+
+  struct stat fileinfo;
+  if (fstat(filefd, &fileinfo) < 0 || (size_t)fileinfo.st_size < sizeof(fileHeader)) {
+    std::cerr << "Error loading session snapshot " << path << ": the file is incomplete" << std::endl;
+    close(filefd);
+    return false;
+  }
+
+  void* data = mmap(0, fileinfo.st_size, PROT_READ, MAP_PRIVATE, filefd, 0);
+  close(filefd);
+
+  if (data == MAP_FAILED) {
+    std::cerr << "Error loading session snapshot " << path << std::endl;
+    return false;
+  }
+
+  const fileHeader* header = (const fileHeader*)data;
+  size_t maxCount = (fileinfo.st_size - sizeof(fileHeader)) / sizeof(indexEntry);
+
+  if (memcmp(header->magic, magic, sizeof(magic)) != 0 || header->count > maxCount) {
+    std::cerr << "Error loading session snapshot " << path << ": not a session snapshot of this version" << std::endl;
+    munmap(data, fileinfo.st_size);
+    return false;
+  }
+
+  mapping = (const char*)data;
+  mappingSize = fileinfo.st_size;
+
+  index = (const indexEntry*)(mapping + sizeof(fileHeader));
+  count = header->count;
+
+  taken.assign(count, false);
+
+  return true;
+}
+
+int64_t kleins::sessionSnapshot::toNanoseconds(std::chrono::time_point<std::chrono::system_clock> time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+const kleins::sessionSnapshot::indexEntry* kleins::sessionSnapshot::lookup(std::string_view key) {
+  if (key.length() != keyLength) {
+    return 0;
+  }
+
+  const indexEntry* found =
+      std::lower_bound(index, index + count, key, [](const indexEntry& entry, std::string_view key) { return memcmp(entry.key, key.data(), keyLength) < 0; });
+
+  if (found == index + count || memcmp(found->key, key.data(), keyLength) != 0) {
+    return 0;
+  }
+
+  return found;
+}
+
+bool kleins::sessionSnapshot::take(std::string_view key, record& saved) {
+  int64_t now = toNanoseconds(std::chrono::system_clock::now());
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const indexEntry* entry = lookup(key);
+  if (!entry || taken[entry - index] || entry->expireTime < now) {
+    return false;
+  }
+
+  size_t dataStart = sizeof(fileHeader) + count * sizeof(indexEntry);
+
+  if (entry->offset < dataStart || entry->offset > mappingSize || entry->length > mappingSize - entry->offset) {
+    return false;
+  }
+
+  taken[entry - index] = true;
+
+  saved.expireTime = std::chrono::time_point<std::chrono::system_clock>(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(entry->expireTime)));
+  saved.data = std::string_view(mapping + entry->offset, entry->length);
+
+  return true;
+}
+
+bool kleins::sessionSnapshot::write(sessionStore& store) {
+  std::lock_guard<std::mutex> writeLock(writeMutex);
+
+  // The sessions to write, their data is either in serialized or still in the mapped snapshot
+  struct pendingEntry {
+    indexEntry entry;
+    const char* source;
+  };
+
+  std::vector<pendingEntry> entries;
+  std::string serialized;
+
+  store.forEach([&entries, &serialized](std::string_view key, const sessionBase* session) {
+    if (key.length() != keyLength) {
+      return;
+    }
+
+    pendingEntry pending;
+    memcpy(pending.entry.key, key.data(), keyLength);
+    pending.entry.expireTime = toNanoseconds(session->getExpireTime());
+    pending.entry.offset = serialized.length();
+
+    session->serialize(serialized);
+
+    pending.entry.length = serialized.length() - pending.entry.offset;
+    pending.source = 0;
+
+    entries.push_back(pending);
+  });
+
+  {
+    int64_t now = toNanoseconds(std::chrono::system_clock::now());
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t dataStart = sizeof(fileHeader) + count * sizeof(indexEntry);
+
+    for (size_t i = 0; i < count; i++) {
+      const indexEntry& entry = index[i];
+
+      if (taken[i] || entry.expireTime < now || entry.offset < dataStart || entry.offset > mappingSize || entry.length > mappingSize - entry.offset) {
+        continue;
+      }
+
+      entries.push_back({entry, mapping});
+    }
+  }
+
+  std::sort(entries.begin(), entries.end(),
+      [](const pendingEntry& first, const pendingEntry& second) { return memcmp(first.entry.key, second.entry.key, keyLength) < 0; });
+
+  std::string temporaryPath = path + ".tmp";
+
+  int filefd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (filefd < 0) {
+    std::cerr << "Error writing session snapshot " << temporaryPath << std::endl;
+    return false;
+  }
+
+  std::string buffer;
+  bool failed = false;
+
+  auto flush = [filefd, &buffer, &failed]() {
+    size_t position = 0;
+
+    while (!failed && position < buffer.length()) {
+      ssize_t written = ::write(filefd, buffer.data() + position, buffer.length() - position);
+
+      if (written <= 0) {
+        failed = true;
+      } else {
+        position += written;
+      }
+    }
+
+    buffer.clear();
+  };
+
+  // Collects small writes, the file is written in pieces of about a megabyte
+  auto output = [&buffer, &flush](const void* data, size_t length) {
+    buffer.append((const char*)data, length);
+
+    if (buffer.length() >= 1024 * 1024) {
+      flush();
+    }
+  };
+
+  fileHeader header;
+  memcpy(header.magic, magic, sizeof(magic));
+  header.count = entries.size();
+  output(&header, sizeof(header));
+
+  uint64_t offset = sizeof(fileHeader) + entries.size() * sizeof(indexEntry);
+
+  for (auto& pending : entries) {
+    indexEntry entry = pending.entry;
+    entry.offset = offset;
+    offset += entry.length;
+
+    output(&entry, sizeof(entry));
+  }
+
+  for (auto& pending : entries) {
+    const char* data = pending.source ? pending.source + pending.entry.offset : serialized.data() + pending.entry.offset;
+    output(data, pending.entry.length);
+  }
+
+  flush();
+
+  if (failed || fsync(filefd) < 0) {
+    std::cerr << "Error writing session snapshot " << temporaryPath << std::endl;
+    close(filefd);
+    unlink(temporaryPath.c_str());
+    return false;
+  }
+
+  close(filefd);
+
+  // The mapped snapshot stays readable after it was replaced
+  if (rename(temporaryPath.c_str(), path.c_str()) < 0) {
+    std::cerr << "Error replacing session snapshot " << path << std::endl;
+    unlink(temporaryPath.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+size_t kleins::sessionSnapshot::size() {
+  return count;
+}
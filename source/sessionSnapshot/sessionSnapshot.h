@@ -0,0 +1,115 @@
+#ifndef SESSIONSNAPSHOT_H
+#define SESSIONSNAPSHOT_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../sessionBase/sessionBase.h"
+#include "../sessionStore/sessionStore.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief A file holding the sessions of an httpServer, so they survive a restart.
+ *
+ * The file starts with an index of all sessions sorted by key, each with its expireTime and where its data is, followed by the data
+ * the sessions wrote with sessionBase::serialize. A snapshot left by the previous run is mapped into memory as it is,
+ * nothing is read up front. A session is only looked up in it and restored when a request comes in with its key.
+ *
+ * Writing a snapshot puts the live sessions and the ones of the previous snapshot that weren't restored yet into a new file,
+ * which then replaces the old one. The file is only meant to be read back by the same build on the same machine.
+ */
+class sessionSnapshot {
+public:
+  static const size_t keyLength = sessionBase::keyLength;
+
+  /**
+   * @brief A session of the snapshot. The data points into the mapped file and stays valid as long as the sessionSnapshot.
+   */
+  struct record {
+    std::chrono::time_point<std::chrono::system_clock> expireTime;
+    std::string_view data;
+  };
+
+private:
+  struct fileHeader {
+    char magic[8];
+    uint64_t count;
+  };
+
+  struct indexEntry {
+    char key[keyLength];
+    int64_t expireTime;
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  static constexpr char magic[8] = {'K', 'H', 'S', 'E', 'S', 'S', '1', 0};
+
+  std::string path;
+
+  const char* mapping = 0;
+  size_t mappingSize = 0;
+
+  const indexEntry* index = 0;
+  size_t count = 0;
+
+  // Guards taken, which marks the sessions of the mapped snapshot that were restored
+  std::mutex mutex;
+  std::vector<bool> taken;
+
+  // Guards writing the file
+  std::mutex writeMutex;
+
+  bool map();
+  const indexEntry* lookup(std::string_view key);
+
+  static int64_t toNanoseconds(std::chrono::time_point<std::chrono::system_clock> time);
+
+public:
+  /**
+   * @brief Use a snapshot file, mapping the snapshot the previous run left there if there is one
+   *
+   * @param filePath Where the snapshot is stored, it's written to filePath + ".tmp" first
+   */
+  sessionSnapshot(const std::string& filePath);
+  ~sessionSnapshot();
+
+  sessionSnapshot(const sessionSnapshot&) = delete;
+  sessionSnapshot& operator=(const sessionSnapshot&) = delete;
+
+  /**
+   * @brief Take a session out of the mapped snapshot, to restore it. Each session can only be taken once.
+   *
+   * @return false if the snapshot has no session with this key that didn't expire yet, or it was taken already
+   */
+  bool take(std::string_view key, record& saved);
+
+  /**
+   * @brief Write the sessions of a store and the ones of the mapped snapshot that weren't taken yet into the snapshot file
+   *
+   * @return false if the file couldn't be written, the previous one is kept then
+   */
+  bool write(sessionStore& store);
+
+  /**
+   * @brief The amount of sessions in the mapped snapshot
+   */
+  size_t size();
+};
+}; // namespace kleins
+
+#endif
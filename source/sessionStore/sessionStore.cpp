@@ -0,0 +1,145 @@
+#include "sessionStore.h"
+
+kleins::sessionStore::shard::shard() : sessions(&nodes), expiry(currentSecond()) {
+}
+
+kleins::sessionStore::sessionStore() {
+}
+
+kleins::sessionStore::~sessionStore() {
+  for (auto& current : shards) {
+    for (auto& stored : current.sessions) {
+      current.expiry.cancel(&stored.second);
+      release(stored.second.session);
+    }
+  }
+}
+
+kleins::sessionStore::shard& kleins::sessionStore::shardOf(std::string_view key) {
+  return shards[std::hash<std::string_view>()(key) % shardCount];
+}
+
+uint64_t kleins::sessionStore::currentSecond() {
+  return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64_t kleins::sessionStore::expirySecond(const sessionBase* session) {
+  auto expireSecond = std::chrono::ceil<std::chrono::seconds>(session->getExpireTime().time_since_epoch()).count();
+
+  return std::max<int64_t>(expireSecond, 0);
+}
+
+kleins::sessionBase* kleins::sessionStore::find(std::string_view key) {
+  auto currentTime = std::chrono::system_clock::now();
+  shard& current = shardOf(key);
+
+  std::lock_guard<std::mutex> lock(current.mutex);
+
+  auto stored = current.sessions.find(key);
+  if (stored == current.sessions.end() || stored->second.session->getExpireTime() < currentTime) {
+    return 0;
+  }
+
+  // Taken while the store's own reference is held, so the session can't be destroyed in between
+  stored->second.session->references.fetch_add(1, std::memory_order_relaxed);
+
+  return stored->second.session;
+}
+
+void kleins::sessionStore::add(sessionBase* session) {
+  const char* keychars = "1234567890ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+  unsigned char randomBytes[sessionBase::keyLength];
+  char key[sessionBase::keyLength];
+
+  // Drawing a key that is taken is next to impossible, but then a new one is drawn
+  do {
+    RAND_bytes(randomBytes, sizeof(randomBytes));
+
+    for (size_t i = 0; i < sizeof(randomBytes); i++) {
+      key[i] = keychars[randomBytes[i] % 62];
+    }
+  } while (!add(session, std::string_view(key, sizeof(key))));
+}
+
+bool kleins::sessionStore::add(sessionBase* session, std::string_view key) {
+  if (key.length() != sessionBase::keyLength) {
+    return false;
+  }
+
+  shard& current = shardOf(key);
+
+  std::lock_guard<std::mutex> lock(current.mutex);
+
+  if (current.sessions.count(key) != 0) {
+    return false;
+  }
+
+  memcpy(session->keyStorage, key.data(), sessionBase::keyLength);
+  session->sessionKey = std::string_view(session->keyStorage, sessionBase::keyLength);
+
+  // One reference for the store and one for the caller
+  session->references.store(2, std::memory_order_relaxed);
+
+  entry& stored = current.sessions[session->sessionKey];
+  stored.session = session;
+
+  current.expiry.schedule(&stored, expirySecond(session));
+  sessionCount++;
+
+  return true;
+}
+
+void kleins::sessionStore::forEach(const std::function<void(std::string_view key, const sessionBase* session)>& visitor) {
+  auto currentTime = std::chrono::system_clock::now();
+
+  for (auto& current : shards) {
+    std::lock_guard<std::mutex> lock(current.mutex);
+
+    for (auto& stored : current.sessions) {
+      if (stored.second.session->getExpireTime() >= currentTime) {
+        visitor(stored.first, stored.second.session);
+      }
+    }
+  }
+}
+
+size_t kleins::sessionStore::expire() {
+  uint64_t now = currentSecond();
+  size_t deleted = 0;
+
+  for (auto& current : shards) {
+    std::lock_guard<std::mutex> lock(current.mutex);
+
+    current.expiry.advance(now, [&current, now, &deleted](timerWheel::timer* fired) {
+      entry* stored = static_cast<entry*>(fired);
+      sessionBase* session = stored->session;
+
+      // The endpoint extended the session since it was scheduled
+      uint64_t due = expirySecond(session);
+      if (due > now) {
+        current.expiry.schedule(stored, due);
+        return;
+      }
+
+      current.sessions.erase(session->sessionKey);
+      release(session);
+
+      deleted++;
+    });
+  }
+
+  sessionCount -= deleted;
+
+  return deleted;
+}
+
+void kleins::sessionStore::release(sessionBase* session) {
+  if (session->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    sessionPoolBase::destroy(session);
+  }
+}
+
+size_t kleins::sessionStore::size() {
+  return sessionCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,120 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <openssl/rand.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#ifndef SINGLE_HEADER
+#include "../sessionBase/sessionBase.h"
+#include "../sessionPool/sessionPool.h"
+#include "../timerWheel/timerWheel.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief The sessions of an httpServer, by their key.
+ *
+ * The sessions are spread over shards by the hash of their key, every shard has its own lock, so threads looking up different sessions
+ * rarely wait for each other. Each shard keeps a timerWheel with a timer per session, ticking once per second,
+ * so expiring sessions only costs something for the sessions that actually expire. The map is keyed by the key stored in the session itself
+ * and takes its nodes from a pool of the shard, so storing a session doesn't reach the general purpose allocator.
+ *
+ * Sessions are reference counted. The store holds one reference while the session is stored, find and add hand out one more
+ * to the caller, which gives it back with release. An expired session is taken out of the store with the next expire,
+ * and destroyed once the last request that looked it up let go of it.
+ */
+class sessionStore {
+public:
+  static const size_t shardCount = 64;
+
+private:
+  struct entry : timerWheel::timer {
+    sessionBase* session = 0;
+  };
+
+  struct alignas(64) shard {
+    std::mutex mutex;
+    std::pmr::unsynchronized_pool_resource nodes;
+    std::pmr::unordered_map<std::string_view, entry> sessions;
+    timerWheel expiry;
+
+    shard();
+  };
+
+  shard shards[shardCount];
+  std::atomic<size_t> sessionCount{0};
+
+  shard& shardOf(std::string_view key);
+
+  static uint64_t currentSecond();
+
+  // The second the session is taken out of the store in, the first one after its expireTime
+  static uint64_t expirySecond(const sessionBase* session);
+
+public:
+  sessionStore();
+
+  /**
+   * @brief Lets go of every session that is left, they are destroyed unless a request still holds them
+   */
+  ~sessionStore();
+
+  sessionStore(const sessionStore&) = delete;
+  sessionStore& operator=(const sessionStore&) = delete;
+
+  /**
+   * @brief Look up a session
+   *
+   * @return The session, 0 if there is none with this key or it expired. The caller holds a reference to it, see release.
+   */
+  sessionBase* find(std::string_view key);
+
+  /**
+   * @brief Store a new session under a random key, which the session's sessionKey points to afterwards
+   *
+   * @param session The session, the store takes ownership and destroys it after it expired, see sessionPoolBase::destroy.
+   * The caller holds a reference to it, like one returned by find.
+   */
+  void add(sessionBase* session);
+
+  /**
+   * @brief Store a session under a given key, e.g. one restored from a sessionSnapshot
+   *
+   * @return false if the key is taken or isn't sessionBase::keyLength long, the session isn't stored then and the caller still owns it
+   */
+  bool add(sessionBase* session, std::string_view key);
+
+  /**
+   * @brief Give back the reference to a session returned by find or add. May be called from any thread.
+   */
+  static void release(sessionBase* session);
+
+  /**
+   * @brief Call visitor with every session that didn't expire yet. Each shard is locked while its sessions are visited.
+   */
+  void forEach(const std::function<void(std::string_view key, const sessionBase* session)>& visitor);
+
+  /**
+   * @brief Take the sessions that expired out of the store. Sessions whose expireTime was pushed back meanwhile are kept.
+   *
+   * @return The amount of sessions taken out
+   */
+  size_t expire();
+
+  /**
+   * @brief The amount of stored sessions, including expired ones that weren't taken out yet
+   */
+  size_t size();
+};
+}; // namespace kleins
+
+#endif
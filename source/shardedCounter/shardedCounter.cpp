@@ -0,0 +1,35 @@
+#include "shardedCounter.h"
+
+kleins::metrics::shardedCounter::shardedCounter() {
+}
+
+unsigned int kleins::metrics::shardedCounter::threadShard() {
+  static std::atomic<unsigned int> nextShard{0};
+
+  // Handed out round robin, so the threads of a server end up on different cells
+  static thread_local unsigned int shard = nextShard.fetch_add(1, std::memory_order_relaxed) % shardCount;
+
+  return shard;
+}
+
+void kleins::metrics::shardedCounter::add(uint64_t value) {
+  cells[threadShard()].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t kleins::metrics::shardedCounter::sum() const {
+  uint64_t total = 0;
+
+  for (auto& current : cells) {
+    total += current.value.load(std::memory_order_relaxed);
+  }
+
+  return total;
+}
+
+void kleins::metrics::shardedCounter::store(uint64_t value) {
+  cells[0].value.store(value, std::memory_order_relaxed);
+
+  for (unsigned int i = 1; i < shardCount; i++) {
+    cells[i].value.store(0, std::memory_order_relaxed);
+  }
+}
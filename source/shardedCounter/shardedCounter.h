@@ -0,0 +1,54 @@
+#ifndef SHARDEDCOUNTER_H
+#define SHARDEDCOUNTER_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace kleins {
+
+namespace metrics {
+
+/**
+ * @brief A counter that many threads can add to at once without losing counts or fighting over one cache line.
+ *
+ * The count is split over shardCount cells on cache lines of their own. Every thread adds to the cell it was given the first time it counted,
+ * so threads only share a cell once there are more of them than cells, and then the atomic add still keeps the count exact.
+ * Reading sums up all cells, which is only done when the metrics are scraped.
+ */
+class shardedCounter {
+public:
+  static const unsigned int shardCount = 32;
+
+private:
+  struct alignas(64) cell {
+    std::atomic<uint64_t> value{0};
+  };
+
+  cell cells[shardCount];
+
+  static unsigned int threadShard();
+
+public:
+  shardedCounter();
+
+  shardedCounter(const shardedCounter&) = delete;
+  shardedCounter& operator=(const shardedCounter&) = delete;
+
+  void add(uint64_t value);
+
+  /**
+   * @brief The sum of all cells
+   */
+  uint64_t sum() const;
+
+  /**
+   * @brief Replace the count. Additions running at the same time may or may not be part of the new count.
+   */
+  void store(uint64_t value);
+};
+
+} // namespace metrics
+
+} // namespace kleins
+
+#endif
@@ -1,17 +1,92 @@
 #include "socketBase.h"
 
-kleins::socketBase::socketBase() {
+kleins::socketBase::socketBase(const listenerOptions& listenOptions) {
+  options = listenOptions;
+
+  if (options.shards == 0) {
+    options.shards = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  shardCount = options.shards;
 }
 
 kleins::socketBase::~socketBase() {
-  delete tickThread;
+  stopTicks();
 }
 
-void kleins::socketBase::tickLoop(socketBase* socket) {
-  while (socket->tick()) {
+void kleins::socketBase::tickLoop(socketBase* socket, unsigned int shard) {
+  while (socket->keepTicking && socket->tick(shard)) {
   };
 }
 
+void kleins::socketBase::interruptTicks() {
+}
+
 void kleins::socketBase::startTicks() {
-  tickThread = new std::thread(tickLoop, this);
-}
\ No newline at end of file
+  for (unsigned int shard = 0; shard < shardCount; shard++) {
+    tickThreads.push_back(new std::thread(tickLoop, this, shard));
+  }
+}
+
+void kleins::socketBase::stopTicks() {
+  keepTicking = false;
+  interruptTicks();
+
+  for (auto tickThread : tickThreads) {
+    tickThread->join();
+    delete tickThread;
+  }
+
+  tickThreads.clear();
+}
+
+int kleins::socketBase::openListenSocket(const struct sockaddr_in& address) {
+  int socketfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+  if (socketfd < 0) {
+    std::cerr << "Error creating socket file descriptor" << std::endl;
+    return -1;
+  }
+
+  int opt = 1;
+  if (setsockopt(socketfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) || setsockopt(socketfd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) ||
+      setsockopt(socketfd, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt))) {
+    std::cerr << "Error setting socket opts" << std::endl;
+    close(socketfd);
+    return -1;
+  }
+
+  if (options.deferAcceptSeconds > 0 && setsockopt(socketfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &options.deferAcceptSeconds, sizeof(int))) {
+    std::cerr << "Error setting TCP_DEFER_ACCEPT" << std::endl;
+    close(socketfd);
+    return -1;
+  }
+
+  if (options.fastOpenQueue > 0 && setsockopt(socketfd, IPPROTO_TCP, TCP_FASTOPEN, &options.fastOpenQueue, sizeof(int))) {
+    std::cerr << "Error setting TCP_FASTOPEN" << std::endl;
+    close(socketfd);
+    return -1;
+  }
+
+  if (bind(socketfd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+    std::cerr << "Error binding socket" << std::endl;
+    close(socketfd);
+    return -1;
+  }
+  if (listen(socketfd, options.backlog) < 0) {
+    std::cerr << "Error listening on socket" << std::endl;
+    close(socketfd);
+    return -1;
+  }
+
+  return socketfd;
+}
+
+bool kleins::socketBase::waitForConnections(int listenfd) {
+  pollfd pollListen;
+  pollListen.fd = listenfd;
+  pollListen.events = POLLIN;
+  pollListen.revents = 0;
+
+  return poll(&pollListen, 1, -1) > 0 || errno == EINTR;
+}
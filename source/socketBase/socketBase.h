@@ -2,11 +2,17 @@
 #define SOCKETBASE_H
 
 #include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
 #include <future>
 #include <iostream>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
 #ifndef SINGLE_HEADER
 #include "../connectionBase/connectionBase.h"
@@ -14,19 +20,82 @@
 
 namespace kleins {
 
+/**
+ * @brief Tuning of the listening sockets of a socketBase
+ */
+struct listenerOptions {
+  /**
+   * @brief The amount of SO_REUSEPORT listeners to open on the address, each with its own accept thread.
+   * Connections accepted by a shard are handled by the matching eventLoop thread. 0 uses one per core.
+   */
+  unsigned int shards = 1;
+
+  /**
+   * @brief The length of the queue of connections waiting to be accepted
+   */
+  int backlog = SOMAXCONN;
+
+  /**
+   * @brief Accept every pending connection per wakeup instead of one
+   */
+  bool batchAccept = true;
+
+  /**
+   * @brief Only wake up for a connection once it sent data, waiting at most this many seconds (TCP_DEFER_ACCEPT). 0 disables it.
+   */
+  int deferAcceptSeconds = 0;
+
+  /**
+   * @brief The amount of pending TCP Fast Open requests, which let clients send their request with the SYN. 0 disables it.
+   */
+  int fastOpenQueue = 0;
+};
+
 class socketBase {
 protected:
-  static void tickLoop(socketBase* socket);
-  std::thread* tickThread;
+  static void tickLoop(socketBase* socket, unsigned int shard);
+  std::vector<std::thread*> tickThreads;
+  std::atomic<bool> keepTicking{true};
 
-  virtual bool tick() = 0;
+  listenerOptions options;
+
+  // The amount of listeners this socket is split into, each one gets its own accept thread
+  unsigned int shardCount = 1;
+
+  virtual bool tick(unsigned int shard) = 0;
+
+  /**
+   * @brief Wake up the tick threads waiting for connections, so they notice that they should stop
+   */
+  virtual void interruptTicks();
+
+  /**
+   * @brief Create a non blocking socket bound to address and listen on it as set up in options.
+   * SO_REUSEPORT is set so several shards can share the address.
+   *
+   * @return The file descriptor, or -1 on error
+   */
+  int openListenSocket(const struct sockaddr_in& address);
+
+  /**
+   * @brief Wait until listenfd has connections to accept
+   *
+   * @return false if waiting failed
+   */
+  bool waitForConnections(int listenfd);
 
 public:
-  socketBase();
-  ~socketBase();
+  socketBase(const listenerOptions& listenOptions = listenerOptions());
+  virtual ~socketBase();
 
   void startTicks();
 
+  /**
+   * @brief Stop accepting connections and wait for the tick threads to finish.
+   * The destructors of derived sockets call this before closing anything tick uses.
+   */
+  void stopTicks();
+
   std::function<void(connectionBase*)> newConnectionCallback;
   virtual std::future<bool> init() = 0;
 };
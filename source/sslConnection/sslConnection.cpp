@@ -5,60 +5,140 @@ kleins::sslConnection::sslConnection(int connectionid, SSL_CTX* sslcontext) {
   ctx = sslcontext;
   ossl = SSL_new(ctx);
   SSL_set_fd(ossl, connectionfd);
-  if (SSL_accept(ossl) <= 0) {
-    ERR_print_errors_fp(stderr);
-    initOk = false;
-  }
+  SSL_set_accept_state(ossl);
+
+  // The socket is accepted non blocking, the handshake is taken a step further whenever the eventLoop sees it ready
+  SSL_set_mode(ossl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
   resetTimeoutTimer();
 }
 
 kleins::sslConnection::~sslConnection() {
   close_socket();
-  join();
 }
 
 bool kleins::sslConnection::getAlive() {
-  if (!initOk) {
-    return false;
+  return !closed;
+}
+
+int kleins::sslConnection::getFd() {
+  return connectionfd;
+}
+
+bool kleins::sslConnection::handleSSLError(int returnValue) {
+  int error = SSL_get_error(ossl, returnValue);
+
+  if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+    return true;
   }
 
-  int error = 0;
-  socklen_t len = sizeof(error);
-  int retval = getsockopt(connectionfd, SOL_SOCKET, SO_ERROR, &error, &len);
+  if (error == SSL_ERROR_ZERO_RETURN) {
+    closeAfterFlush();
+    return false;
+  }
 
-  return (error | retval) == 0;
+  close_socket();
+  return false;
 }
 
-void kleins::sslConnection::tick() {
-  packet* packetBuffer = new packet;
+bool kleins::sslConnection::continueHandshake() {
+  handshakeWantsWrite = false;
+  int returnValue = SSL_accept(ossl);
+
+  if (returnValue == 1) {
+    handshakeDone = true;
+    clearReadDeadline();
+    resetTimeoutTimer();
+    return true;
+  }
+
+  int error = SSL_get_error(ossl, returnValue);
+
+  if (error == SSL_ERROR_WANT_READ) {
+    return false;
+  }
+
+  if (error == SSL_ERROR_WANT_WRITE) {
+    handshakeWantsWrite = true;
+    return false;
+  }
+
+  ERR_print_errors_fp(stderr);
+  close_socket();
+  return false;
+}
 
-  packetBuffer->data.resize(4096);
-  SSL_read_ex(ossl, (char*)&packetBuffer->data[0], 4096, (size_t*)&packetBuffer->size);
+bool kleins::sslConnection::hasPendingOutput() {
+  return handshakeWantsWrite || connectionBase::hasPendingOutput();
+}
 
-  if (!packetBuffer->size) {
-    usleep(20000);
-    delete packetBuffer;
+bool kleins::sslConnection::handshakePending() {
+  return !handshakeDone;
+}
 
-    if (getTimeout()) {
-      close_socket();
+void kleins::sslConnection::flush() {
+  if (!handshakeDone) {
+    // The data the handshake is waiting on may already be there, so go on reading right away when it completes
+    if (continueHandshake()) {
+      tick();
     }
+    return;
+  }
 
+  connectionBase::flush();
+}
+
+void kleins::sslConnection::tick() {
+  if (!handshakeDone && !continueHandshake()) {
     return;
   }
 
-  resetTimeoutTimer();
+  // OpenSSL may have buffered more records than epoll knows about, so keep reading while it has some
+  do {
+    packet* packetBuffer = new packet;
+
+    packetBuffer->data.resize(4096);
+    size_t readBytes = 0;
+    int returnValue = SSL_read_ex(ossl, (char*)&packetBuffer->data[0], 4096, &readBytes);
 
-  packetBuffer->data.resize(packetBuffer->size);
+    if (returnValue <= 0) {
+      delete packetBuffer;
+      handleSSLError(returnValue);
+      return;
+    }
 
-  this->onRecieveCallback(std::unique_ptr<packet>(packetBuffer));
+    resetTimeoutTimer();
+
+    packetBuffer->size = readBytes;
+    packetBuffer->data.resize(packetBuffer->size);
+
+    this->onRecieveCallback(std::unique_ptr<packet>(packetBuffer));
+  } while (!closed && SSL_pending(ossl) > 0);
 }
 
-void kleins::sslConnection::sendData(const char* data, int datalength) {
-  SSL_write(ossl, data, datalength);
+ssize_t kleins::sslConnection::writeSome(const char* data, size_t length) {
+  size_t written = 0;
+  int returnValue = SSL_write_ex(ossl, data, length, &written);
+
+  if (returnValue <= 0) {
+    int error = SSL_get_error(ossl, returnValue);
+    return (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) ? 0 : -1;
+  }
+
+  return written;
 }
 
 void kleins::sslConnection::close_socket() {
-  SSL_shutdown(ossl);
+  if (closed) {
+    return;
+  }
+
+  closed = true;
+
+  // A shutdown alert only makes sense on a connection that finished its handshake
+  if (handshakeDone) {
+    SSL_shutdown(ossl);
+  }
   SSL_free(ossl);
   close(connectionfd);
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #ifndef CONNECTION_H
 #define CONNECTION_H
 
+#include <cerrno>
+#include <fcntl.h>
 #include <future>
 #include <iostream>
 #include <list>
@@ -21,16 +23,33 @@ private:
   int connectionfd;
   SSL_CTX* ctx;
   SSL* ossl;
-  bool initOk = true;
+  bool handshakeDone = false;
+  bool handshakeWantsWrite = false;
+
+  bool handleSSLError(int returnValue);
+
+  /**
+   * @brief Take the TLS handshake as far as the socket allows without blocking
+   *
+   * @return Whether the handshake is done
+   */
+  bool continueHandshake();
+
+protected:
+  virtual ssize_t writeSome(const char* data, size_t length);
 
 public:
   sslConnection(int connectionid, SSL_CTX* sslcontext);
   ~sslConnection();
 
   virtual bool getAlive();
+  virtual int getFd();
   virtual void tick();
-  virtual void sendData(const char* data, int datalength);
+  virtual void flush();
   virtual void close_socket();
+
+  virtual bool hasPendingOutput();
+  virtual bool handshakePending();
 };
 }; // namespace kleins
 
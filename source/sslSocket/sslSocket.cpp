@@ -1,6 +1,8 @@
 #include "sslSocket.h"
 
-kleins::sslSocket::sslSocket(const char* listenAddress, const int listenPort, const char* pathToCertificate, const char* pathToKey) {
+kleins::sslSocket::sslSocket(
+    const char* listenAddress, const int listenPort, const char* pathToCertificate, const char* pathToKey, const listenerOptions& listenOptions)
+    : socketBase(listenOptions) {
   address.sin_family = AF_INET;
 
   address.sin_port = htons(listenPort);
@@ -34,46 +36,56 @@ kleins::sslSocket::sslSocket(const char* listenAddress, const int listenPort, co
 }
 
 kleins::sslSocket::~sslSocket() {
-  close(socketfd);
+  stopTicks();
+
+  for (auto socketfd : socketfds) {
+    close(socketfd);
+  }
+}
+
+void kleins::sslSocket::interruptTicks() {
+  // Wakes up the poll in waitForConnections, accept fails from then on
+  for (auto socketfd : socketfds) {
+    shutdown(socketfd, SHUT_RDWR);
+  }
 }
 
-bool kleins::sslSocket::tick() {
-  int newConnection;
+bool kleins::sslSocket::tick(unsigned int shard) {
+  if (!waitForConnections(socketfds[shard])) {
+    return false;
+  }
 
-  newConnection = accept(socketfd, (struct sockaddr*)&address, (socklen_t*)&addrlen);
-  sslConnection* conn = new sslConnection(newConnection, ctx);
-  newConnectionCallback(conn);
+  // The handshake is driven by the eventLoop, a client that is slow to send its hello doesn't hold up the ones accepted after it
+  do {
+    int newConnection = accept4(socketfds[shard], 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (newConnection < 0) {
+      break;
+    }
 
-  return newConnection;
+    sslConnection* conn = new sslConnection(newConnection, ctx);
+    if (shardCount > 1) {
+      conn->shard = shard;
+    }
+    newConnectionCallback(conn);
+  } while (options.batchAccept);
+
+  return true;
 }
 
 std::future<bool> kleins::sslSocket::init() {
   auto init_async = [this]() {
-    socketfd = socket(AF_INET, SOCK_STREAM, 0);
+    for (unsigned int shard = 0; shard < shardCount; shard++) {
+      int socketfd = openListenSocket(address);
 
-    if (!socketfd) {
-      std::cerr << "Error creating socket file descriptor" << std::endl;
-      return false;
-    }
+      if (socketfd < 0) {
+        return false;
+      }
 
-    if (setsockopt(socketfd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT | SO_KEEPALIVE, &opt, sizeof(opt))) {
-      std::cerr << "Error setting socket opts" << std::endl;
-      return false;
+      socketfds.push_back(socketfd);
     }
 
-    if (bind(socketfd, (struct sockaddr*)&address, sizeof(address)) < 0) {
-      std::cerr << "Error binding socket" << std::endl;
-      return false;
-    }
-    if (listen(socketfd, 3) < 0) {
-      std::cerr << "Error listening on socket" << std::endl;
-      return false;
-    }
-
-    addrlen = sizeof(address);
-
     return true;
   };
 
   return std::async(std::launch::async, init_async);
-}
\ No newline at end of file
+}
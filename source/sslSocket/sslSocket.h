@@ -9,6 +9,7 @@
 #include <openssl/ssl.h>
 #include <sys/socket.h>
 #include <thread>
+#include <vector>
 
 #ifndef SINGLE_HEADER
 #include "../socketBase/socketBase.h"
@@ -18,17 +19,27 @@
 namespace kleins {
 class sslSocket : public socketBase {
 private:
-  int socketfd;
-  int opt;
+  std::vector<int> socketfds;
   struct sockaddr_in address;
-  int addrlen;
 
   SSL_CTX* ctx;
 
-  bool tick();
+  bool tick(unsigned int shard);
+  void interruptTicks();
 
 public:
-  sslSocket(const char* listenAddress, const int listenPort, const char* pathToCertificate, const char* pathToKey);
+  /**
+   * @brief Construct a new ssl socket
+   *
+   * @param listenAddress The address to listen on
+   * @param listenPort The port to listen on
+   * @param pathToCertificate Path to the PEM certificate
+   * @param pathToKey Path to the PEM private key
+   * @param listenOptions Sharding, backlog and accept tuning of the listener
+   */
+  sslSocket(
+      const char* listenAddress, const int listenPort, const char* pathToCertificate, const char* pathToKey,
+      const listenerOptions& listenOptions = listenerOptions());
   ~sslSocket();
 
   std::future<bool> init();
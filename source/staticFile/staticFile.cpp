@@ -0,0 +1,319 @@
+#include "staticFile.h"
+
+kleins::staticFile::staticFile(const std::string& filepath, const std::string& type, const std::string& cacheControl) {
+  path = filepath;
+  mimeType = type;
+
+  int filefd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (filefd < 0) {
+    return;
+  }
+
+  struct stat fileinfo;
+  if (fstat(filefd, &fileinfo) < 0) {
+    close(filefd);
+    return;
+  }
+
+  size = fileinfo.st_size;
+  modified = fileinfo.st_mtime;
+
+  if (!hashContent(filefd)) {
+    close(filefd);
+    return;
+  }
+
+  char modifiedString[64];
+  struct tm modifiedTime;
+  gmtime_r(&modified, &modifiedTime);
+  strftime(modifiedString, sizeof(modifiedString), "%a, %d %b %Y %H:%M:%S GMT", &modifiedTime);
+  lastModified = modifiedString;
+
+  responseHeaders.push_back("Accept-Ranges: bytes");
+  responseHeaders.push_back("ETag: " + etag);
+  responseHeaders.push_back("Last-Modified: " + lastModified);
+
+  if (!cacheControl.empty()) {
+    responseHeaders.push_back("Cache-Control: " + cacheControl);
+  }
+
+  if (size <= maxSerializedBodySize && !serializeResponse(filefd)) {
+    close(filefd);
+    return;
+  }
+
+  close(filefd);
+  loaded = true;
+}
+
+kleins::staticFile::descriptor::descriptor(int openFd) {
+  fd = openFd;
+}
+
+kleins::staticFile::descriptor::~descriptor() {
+  close(fd);
+}
+
+bool kleins::staticFile::serializeResponse(int filefd) {
+  responseBuilder response(std::pmr::new_delete_resource(), 512 + size);
+
+  response.contentLength(size);
+  response.contentType(mimeType);
+
+  for (auto& responseHeader : responseHeaders) {
+    response.header(responseHeader);
+  }
+
+  response.server();
+  response.endHead();
+
+  serializedResponse.assign(response.data(), response.length());
+  serializedResponse.resize(response.length() + size);
+
+  size_t offset = 0;
+
+  while (offset < size) {
+    ssize_t readBytes = pread(filefd, &serializedResponse[response.length() + offset], size - offset, offset);
+
+    if (readBytes <= 0) {
+      serializedResponse.clear();
+      return false;
+    }
+
+    offset += readBytes;
+  }
+
+  return true;
+}
+
+bool kleins::staticFile::hashContent(int filefd) {
+  EVP_MD_CTX* context = EVP_MD_CTX_new();
+  EVP_DigestInit_ex(context, EVP_sha256(), 0);
+
+  char buffer[65536];
+  off_t offset = 0;
+
+  while ((size_t)offset < size) {
+    ssize_t readBytes = pread(filefd, buffer, sizeof(buffer), offset);
+
+    if (readBytes <= 0) {
+      EVP_MD_CTX_free(context);
+      return false;
+    }
+
+    EVP_DigestUpdate(context, buffer, readBytes);
+    offset += readBytes;
+  }
+
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digestLength = 0;
+  EVP_DigestFinal_ex(context, digest, &digestLength);
+  EVP_MD_CTX_free(context);
+
+  // Half of the hash is plenty to tell versions of a file apart
+  const char* hexDigits = "0123456789abcdef";
+
+  etag = "\"";
+  for (unsigned int i = 0; i < 16; i++) {
+    etag += hexDigits[digest[i] >> 4];
+    etag += hexDigits[digest[i] & 0xf];
+  }
+  etag += "\"";
+
+  return true;
+}
+
+kleins::staticFile::~staticFile() {
+}
+
+bool kleins::staticFile::isLoaded() {
+  return loaded;
+}
+
+std::shared_ptr<const kleins::staticFile::descriptor> kleins::staticFile::openDescriptor() {
+  std::lock_guard<std::mutex> lock(descriptorMutex);
+
+  std::shared_ptr<const descriptor> opened = sharedDescriptor.lock();
+  if (opened) {
+    return opened;
+  }
+
+  int filefd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (filefd < 0) {
+    std::cerr << "Error opening file " << path << ": " << strerror(errno) << std::endl;
+    return opened;
+  }
+
+  opened = std::make_shared<const descriptor>(filefd);
+
+  // The headers and the length of the responses were worked out from the file as it was when it was added
+  struct stat fileinfo;
+  if (fstat(filefd, &fileinfo) < 0 || (size_t)fileinfo.st_size != size || fileinfo.st_mtime != modified) {
+    std::cerr << "Error serving file " << path << ": it changed since it was added" << std::endl;
+    return std::shared_ptr<const descriptor>();
+  }
+
+  sharedDescriptor = opened;
+
+  return opened;
+}
+
+size_t kleins::staticFile::getSize() {
+  return size;
+}
+
+const std::string& kleins::staticFile::getPath() {
+  return path;
+}
+
+const std::string& kleins::staticFile::getMimeType() {
+  return mimeType;
+}
+
+const std::string& kleins::staticFile::getETag() {
+  return etag;
+}
+
+const std::list<std::string>& kleins::staticFile::getHeaders() {
+  return responseHeaders;
+}
+
+std::string_view kleins::staticFile::getSerializedResponse() {
+  return serializedResponse;
+}
+
+bool kleins::staticFile::etagListed(const std::string& ifNoneMatch) {
+  size_t start = 0;
+
+  while (start < ifNoneMatch.length()) {
+    size_t end = ifNoneMatch.find(',', start);
+    if (end == std::string::npos) {
+      end = ifNoneMatch.length();
+    }
+
+    std::string tag = ifNoneMatch.substr(start, end - start);
+    start = end + 1;
+
+    tag.erase(0, tag.find_first_not_of(" \t"));
+    tag.erase(tag.find_last_not_of(" \t") + 1);
+
+    // If-None-Match uses the weak comparison, W/ tags match their strong counterpart
+    if (tag.compare(0, 2, "W/") == 0) {
+      tag.erase(0, 2);
+    }
+
+    if (tag == "*" || tag == etag) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool kleins::staticFile::isNotModified(std::string_view ifNoneMatch, std::string_view ifModifiedSince) {
+  if (!ifNoneMatch.empty()) {
+    // If-Modified-Since is ignored when both are sent
+    return etagListed(std::string(ifNoneMatch));
+  }
+
+  if (!ifModifiedSince.empty()) {
+    struct tm sinceTime = {};
+
+    if (strptime(std::string(ifModifiedSince).c_str(), "%a, %d %b %Y %H:%M:%S GMT", &sinceTime) == 0) {
+      return false;
+    }
+
+    return modified <= timegm(&sinceTime);
+  }
+
+  return false;
+}
+
+bool kleins::staticFile::parseRange(const std::string& range, std::vector<byteRange>& ranges) {
+  if (range.compare(0, 6, "bytes=") != 0) {
+    return false;
+  }
+
+  size_t start = 6;
+
+  while (start < range.length()) {
+    size_t end = range.find(',', start);
+    if (end == std::string::npos) {
+      end = range.length();
+    }
+
+    std::string spec = range.substr(start, end - start);
+    start = end + 1;
+
+    spec.erase(0, spec.find_first_not_of(" \t"));
+    spec.erase(spec.find_last_not_of(" \t") + 1);
+
+    if (spec.empty()) {
+      continue;
+    }
+
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos || spec.find_first_not_of("0123456789-") != std::string::npos || spec.find('-', dash + 1) != std::string::npos) {
+      return false;
+    }
+
+    std::string first = spec.substr(0, dash);
+    std::string last = spec.substr(dash + 1);
+
+    if (first.empty() && last.empty()) {
+      return false;
+    }
+
+    if (first.length() > 18 || last.length() > 18) {
+      return false;
+    }
+
+    if (first.empty()) {
+      // A suffix, the last n bytes of the file
+      size_t suffix = std::stoull(last);
+
+      if (suffix > 0 && size > 0) {
+        suffix = std::min(suffix, size);
+        ranges.push_back({(off_t)(size - suffix), suffix});
+      }
+      continue;
+    }
+
+    size_t firstByte = std::stoull(first);
+    size_t lastByte = last.empty() ? size - 1 : std::stoull(last);
+
+    if (!last.empty() && lastByte < firstByte) {
+      return false;
+    }
+
+    // Ranges starting past the end can't be satisfied, they are left out
+    if (firstByte >= size) {
+      continue;
+    }
+
+    lastByte = std::min(lastByte, size - 1);
+    ranges.push_back({(off_t)firstByte, lastByte - firstByte + 1});
+  }
+
+  return ranges.size() <= maxRanges;
+}
+
+bool kleins::staticFile::requestedRanges(std::string_view range, std::string_view ifRange, std::vector<byteRange>& ranges) {
+  if (range.empty()) {
+    return false;
+  }
+
+  // If-Range only allows a partial response as long as the client still has the current version
+  if (!ifRange.empty() && ifRange != etag && ifRange != lastModified) {
+    return false;
+  }
+
+  ranges.clear();
+
+  if (!parseRange(std::string(range), ranges)) {
+    ranges.clear();
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,141 @@
+#ifndef STATICFILE_H
+#define STATICFILE_H
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <openssl/evp.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef SINGLE_HEADER
+#include "../responseBuilder/responseBuilder.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief A file served by httpServer::serve.
+ *
+ * The file is only open while responses send it, so serving many files doesn't use up the descriptors connections need.
+ * Responses hand the descriptor to the connection so the body goes from the page cache to the socket without being copied through userspace.
+ * The validators for conditional requests (ETag and Last-Modified) are computed once when the file is added.
+ * Small files are also read into a response serialized up front, which plain requests for them get with one copy.
+ */
+class staticFile {
+public:
+  struct byteRange {
+    off_t offset;
+    size_t length;
+  };
+
+  // Requests asking for more ranges than this get the whole file instead
+  static const size_t maxRanges = 16;
+
+  // Files up to this size are kept in memory as part of their serialized response
+  static const size_t maxSerializedBodySize = 16 * 1024;
+
+  /**
+   * @brief An open descriptor of the file, closed once the last response holding it was sent
+   */
+  struct descriptor {
+    int fd;
+
+    descriptor(int openFd);
+    ~descriptor();
+
+    descriptor(const descriptor&) = delete;
+    descriptor& operator=(const descriptor&) = delete;
+  };
+
+private:
+  bool loaded = false;
+  size_t size = 0;
+
+  std::string path;
+  std::string mimeType;
+
+  // A hash of the content, quoted as it's sent
+  std::string etag;
+  time_t modified = 0;
+  std::string lastModified;
+
+  std::list<std::string> responseHeaders;
+
+  // Everything of a 200 response after the status line and the headers depending on the request: the fixed headers, the empty line and the body
+  std::string serializedResponse;
+
+  // Shared by the responses sending the file at the same time
+  std::mutex descriptorMutex;
+  std::weak_ptr<const descriptor> sharedDescriptor;
+
+  bool hashContent(int filefd);
+  bool serializeResponse(int filefd);
+  bool etagListed(const std::string& ifNoneMatch);
+  bool parseRange(const std::string& range, std::vector<byteRange>& ranges);
+
+public:
+  /**
+   * @brief Read a file to be served. It's closed again afterwards, see openDescriptor.
+   *
+   * @param filepath The local path of the file
+   * @param type The mime type the file is served with
+   * @param cacheControl The value of the Cache-Control header sent with the file, none is sent if it's empty
+   */
+  staticFile(const std::string& filepath, const std::string& type, const std::string& cacheControl = "");
+  ~staticFile();
+
+  /**
+   * @brief Whether the file could be read when it was added
+   */
+  bool isLoaded();
+
+  /**
+   * @brief Open the file for a response, or share the descriptor of the responses sending it right now. May be called from any thread.
+   *
+   * @return 0 if the file can't be opened, or it changed since it was added and its size and validators don't match anymore
+   */
+  std::shared_ptr<const descriptor> openDescriptor();
+
+  size_t getSize();
+  const std::string& getPath();
+  const std::string& getMimeType();
+  const std::string& getETag();
+
+  /**
+   * @brief The ETag, Last-Modified and Cache-Control headers to send along with the file
+   */
+  const std::list<std::string>& getHeaders();
+
+  /**
+   * @brief The 200 response for the file without its status line and the headers depending on the request, see httpParser::respondSerialized.
+   * Empty if the file is too big to be kept in memory.
+   */
+  std::string_view getSerializedResponse();
+
+  /**
+   * @brief Check the If-None-Match and If-Modified-Since headers of a request against the file, empty values stand for missing headers
+   *
+   * @return true if the client already has the current version and a 304 should be sent instead
+   */
+  bool isNotModified(std::string_view ifNoneMatch, std::string_view ifModifiedSince);
+
+  /**
+   * @brief Work out which parts of the file a request asks for with its Range and If-Range headers, empty values stand for missing headers
+   *
+   * @param ranges Filled with the satisfiable ranges, clamped to the file. Empty if none of the requested ranges can be satisfied.
+   * @return false if the whole file should be sent, because there is no usable Range header or If-Range doesn't match
+   */
+  bool requestedRanges(std::string_view range, std::string_view ifRange, std::vector<byteRange>& ranges);
+};
+}; // namespace kleins
+
+#endif
@@ -2,20 +2,26 @@
 
 kleins::tcpConnection::tcpConnection(int connectionid) {
   connectionfd = connectionid;
+
+  // Sockets from tcpSocket are accepted non blocking already
+  int flags = fcntl(connectionfd, F_GETFL);
+  if (!(flags & O_NONBLOCK)) {
+    fcntl(connectionfd, F_SETFL, flags | O_NONBLOCK);
+  }
+
   resetTimeoutTimer();
 }
 
 kleins::tcpConnection::~tcpConnection() {
   close_socket();
-  join();
 }
 
 bool kleins::tcpConnection::getAlive() {
-  int error = 0;
-  socklen_t len = sizeof(error);
-  int retval = getsockopt(connectionfd, SOL_SOCKET, SO_ERROR, &error, &len);
+  return !closed && connectionfd >= 0;
+}
 
-  return (error | retval) == 0;
+int kleins::tcpConnection::getFd() {
+  return connectionfd;
 }
 
 void kleins::tcpConnection::tick() {
@@ -24,14 +30,15 @@ void kleins::tcpConnection::tick() {
   packetBuffer->data.resize(4096);
   packetBuffer->size = recv(connectionfd, (char*)&packetBuffer->data[0], 4096, MSG_DONTWAIT);
 
-  if (packetBuffer->size == -1) {
-    delete packetBuffer;
-    usleep(20000);
-
-    if (getTimeout()) {
+  if (packetBuffer->size <= 0) {
+    // Zero means the peer is done sending, anything but EAGAIN is a real error
+    if (packetBuffer->size == 0) {
+      closeAfterFlush();
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
       close_socket();
     }
 
+    delete packetBuffer;
     return;
   }
 
@@ -42,10 +49,33 @@ void kleins::tcpConnection::tick() {
   this->onRecieveCallback(std::unique_ptr<packet>(packetBuffer));
 }
 
-void kleins::tcpConnection::sendData(const char* data, int datalength) {
-  send(connectionfd, data, datalength, 0);
+ssize_t kleins::tcpConnection::writeSome(const char* data, size_t length) {
+  ssize_t sent = send(connectionfd, data, length, MSG_NOSIGNAL);
+
+  if (sent < 0) {
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+  }
+
+  return sent;
+}
+
+ssize_t kleins::tcpConnection::sendFileSome(int filefd, off_t offset, size_t length) {
+  // The kernel copies straight from the page cache, the file never passes through this process
+  ssize_t sent = sendfile(connectionfd, filefd, &offset, length);
+
+  if (sent < 0) {
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+  }
+
+  // Nothing sent means the file is shorter than expected
+  return sent == 0 ? -1 : sent;
 }
 
 void kleins::tcpConnection::close_socket() {
+  if (closed) {
+    return;
+  }
+
+  closed = true;
   close(connectionfd);
-}
\ No newline at end of file
+}
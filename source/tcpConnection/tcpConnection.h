@@ -1,9 +1,12 @@
 #ifndef CONNECTION_H
 #define CONNECTION_H
 
+#include <cerrno>
+#include <fcntl.h>
 #include <future>
 #include <iostream>
 #include <list>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <thread>
 #include <unistd.h>
@@ -18,13 +21,17 @@ class tcpConnection : public connectionBase {
 private:
   int connectionfd;
 
+protected:
+  virtual ssize_t writeSome(const char* data, size_t length);
+  virtual ssize_t sendFileSome(int filefd, off_t offset, size_t length);
+
 public:
   tcpConnection(int connectionid);
   ~tcpConnection();
 
   virtual bool getAlive();
+  virtual int getFd();
   virtual void tick();
-  virtual void sendData(const char* data, int datalength);
   virtual void close_socket();
 };
 }; // namespace kleins
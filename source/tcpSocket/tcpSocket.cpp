@@ -1,6 +1,6 @@
 #include "tcpSocket.h"
 
-kleins::tcpSocket::tcpSocket(const char* listenAddress, const int listenPort) {
+kleins::tcpSocket::tcpSocket(const char* listenAddress, const int listenPort, const listenerOptions& listenOptions) : socketBase(listenOptions) {
   address.sin_family = AF_INET;
 
   address.sin_port = htons(listenPort);
@@ -8,46 +8,56 @@ kleins::tcpSocket::tcpSocket(const char* listenAddress, const int listenPort) {
 }
 
 kleins::tcpSocket::~tcpSocket() {
-  close(socketfd);
+  stopTicks();
+
+  for (auto socketfd : socketfds) {
+    close(socketfd);
+  }
+}
+
+void kleins::tcpSocket::interruptTicks() {
+  // Wakes up the poll in waitForConnections, accept fails from then on
+  for (auto socketfd : socketfds) {
+    shutdown(socketfd, SHUT_RDWR);
+  }
 }
 
-bool kleins::tcpSocket::tick() {
-  int newConnection;
+bool kleins::tcpSocket::tick(unsigned int shard) {
+  if (!waitForConnections(socketfds[shard])) {
+    return false;
+  }
 
-  newConnection = accept(socketfd, (struct sockaddr*)&address, (socklen_t*)&addrlen);
-  tcpConnection* conn = new tcpConnection(newConnection);
-  newConnectionCallback(conn);
+  // With batchAccept a burst of connections costs one wakeup instead of one per connection
+  do {
+    int newConnection = accept4(socketfds[shard], 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (newConnection < 0) {
+      break;
+    }
+
+    tcpConnection* conn = new tcpConnection(newConnection);
+    if (shardCount > 1) {
+      conn->shard = shard;
+    }
+    newConnectionCallback(conn);
+  } while (options.batchAccept);
 
-  return newConnection;
+  return true;
 }
 
 std::future<bool> kleins::tcpSocket::init() {
   auto init_async = [this]() {
-    socketfd = socket(AF_INET, SOCK_STREAM, 0);
+    for (unsigned int shard = 0; shard < shardCount; shard++) {
+      int socketfd = openListenSocket(address);
 
-    if (!socketfd) {
-      std::cerr << "Error creating socket file descriptor" << std::endl;
-      return false;
-    }
-
-    if (setsockopt(socketfd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT | SO_KEEPALIVE, &opt, sizeof(opt))) {
-      std::cerr << "Error setting socket opts" << std::endl;
-      return false;
-    }
+      if (socketfd < 0) {
+        return false;
+      }
 
-    if (bind(socketfd, (struct sockaddr*)&address, sizeof(address)) < 0) {
-      std::cerr << "Error binding socket" << std::endl;
-      return false;
+      socketfds.push_back(socketfd);
     }
-    if (listen(socketfd, 3) < 0) {
-      std::cerr << "Error listening on socket" << std::endl;
-      return false;
-    }
-
-    addrlen = sizeof(address);
 
     return true;
   };
 
   return std::async(std::launch::async, init_async);
-}
\ No newline at end of file
+}
@@ -7,6 +7,7 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <thread>
+#include <vector>
 
 #ifndef SINGLE_HEADER
 #include "../socketBase/socketBase.h"
@@ -16,15 +17,21 @@
 namespace kleins {
 class tcpSocket : public socketBase {
 private:
-  int socketfd;
-  int opt;
+  std::vector<int> socketfds;
   struct sockaddr_in address;
-  int addrlen;
 
-  bool tick();
+  bool tick(unsigned int shard);
+  void interruptTicks();
 
 public:
-  tcpSocket(const char* listenAddress, const int listenPort);
+  /**
+   * @brief Construct a new tcp socket
+   *
+   * @param listenAddress The address to listen on
+   * @param listenPort The port to listen on
+   * @param listenOptions Sharding, backlog and accept tuning of the listener
+   */
+  tcpSocket(const char* listenAddress, const int listenPort, const listenerOptions& listenOptions = listenerOptions());
   ~tcpSocket();
 
   std::future<bool> init();
@@ -5,42 +5,89 @@
 
 template <class T> kleins::sessionBase* kleins::httpParser::startSession() {
   kleins::sessionBase* sb;
-  if (headers["Cookie"].length() > 19) {
-    std::string cookie = headers["Cookie"].substr(19);
-    sb = server->startSession<T>(cookie);
-  } else {
-    sb = server->startSession<T>(headers["Cookie"]);
+  std::string_view cookie = getHeader("Cookie");
+  if (cookie.length() > 19) {
+    cookie.remove_prefix(19);
   }
+  // Asked again during the same request, the session it already started is the one meant
+  if (session) {
+    return session;
+  }
+
+  sb = server->startSession<T>(cookie);
   sessionKey = sb->sessionKey;
+  session = sb;
   return sb;
 }
 
-template <class T> kleins::sessionBase* kleins::httpServer::startSession(std::string& authKey) {
-  try {
-    auto it = sessions.at(authKey);
-    return it;
-  } catch (const std::out_of_range& oor) {
+template <class T> kleins::sessionPool<T>* kleins::httpServer::getSessionPool() {
+  std::lock_guard<std::mutex> lock(sessionPoolMutex);
+
+  std::unique_ptr<sessionPoolBase>& pool = sessionPools[std::type_index(typeid(T))];
+  if (!pool) {
+    pool.reset(new sessionPool<T>());
   }
 
-  const char* keychars = "1234567890ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  return static_cast<sessionPool<T>*>(pool.get());
+}
 
-  char* newKey = new char[33];
-  newKey[32] = 0;
+template <class T> kleins::sessionBase* kleins::httpServer::startSession(std::string_view authKey) {
+  sessionBase* existing = sessions.find(authKey);
+  if (existing) {
+    return existing;
+  }
 
-  RAND_bytes((unsigned char*)newKey, 32);
+  sessionSnapshot* saved = snapshot.load(std::memory_order_acquire);
+  sessionSnapshot::record restored;
 
-  for (int i = 0; i < 32; i++) {
-    newKey[i] = keychars[((unsigned int)newKey[i]) % 62];
-  };
+  // A session from before the restart, restored the first time it's used
+  if (saved && saved->take(authKey, restored)) {
+    T* sb = getSessionPool<T>()->create();
 
-  auto sb = new T();
+    if (sb->deserialize(restored.data)) {
+      sb->setExpireTime(restored.expireTime);
 
-  auto ins = sessions.insert(std::make_pair(std::string(newKey), sb));
+      if (sessions.add(sb, authKey)) {
+        if (metric_activeSessions) {
+          metric_activeSessions->set(sessions.size());
+        }
 
-  metric_totalSessions->inc();
-  metric_activeSessions->set(metric_activeSessions->get() + 1);
+        return sb;
+      }
+    }
 
-  sb->sessionKey = &ins.first->first;
+    sessionPoolBase::destroy(sb);
+  }
+
+  T* sb = getSessionPool<T>()->create();
+  sessions.add(sb);
+
+  if (metric_totalSessions) {
+    metric_totalSessions->inc();
+    metric_activeSessions->set(sessions.size());
+  }
 
   return sb;
 }
+
+template <class table> bool kleins::httpServer::dispatchRouteTable(const void* routes, httpParser* parser) {
+  return ((const table*)routes)->dispatch(parser->method, parser->path, parser);
+}
+
+template <class... handlers> void kleins::httpServer::on(const routeTable<handlers...>& table) {
+  std::lock_guard<std::mutex> lock(routeTableMutex);
+
+  std::shared_ptr<const routeTable<handlers...>> stored = std::make_shared<const routeTable<handlers...>>(table);
+  routeTableStorage.push_back(stored);
+
+  std::vector<compiledRouteTable> tables;
+  tables.push_back({stored.get(), &dispatchRouteTable<routeTable<handlers...>>});
+
+  const std::vector<compiledRouteTable>* previous = compiledRoutes.load(std::memory_order_acquire);
+  if (previous) {
+    tables.insert(tables.end(), previous->begin(), previous->end());
+  }
+
+  routeTables.push_back(std::move(tables));
+  compiledRoutes.store(&routeTables.back(), std::memory_order_release);
+}
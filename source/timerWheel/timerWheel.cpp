@@ -0,0 +1,133 @@
+#include "timerWheel.h"
+
+bool kleins::timerWheel::timer::isScheduled() const {
+  return slot != 0;
+}
+
+kleins::timerWheel::timerWheel(uint64_t startTick) {
+  currentTick = startTick;
+}
+
+void kleins::timerWheel::place(timer* entry) {
+  // The slot of the current tick was already fired, overdue timers go into the next one
+  uint64_t position = std::max(entry->deadline, currentTick + 1);
+  uint64_t distance = position - currentTick;
+
+  unsigned int level = 0;
+  while (level < levelCount - 1 && distance >= (1ull << (slotBits * (level + 1)))) {
+    level++;
+  }
+
+  // Out of reach of the last level, parked in its farthest slot and placed again once that comes around
+  if (distance >= (1ull << (slotBits * levelCount))) {
+    position = currentTick + (1ull << (slotBits * levelCount)) - (1ull << (slotBits * (levelCount - 1)));
+  }
+
+  timer** slot = &slots[level][(position >> (slotBits * level)) & (slotCount - 1)];
+
+  entry->slot = slot;
+  entry->previous = 0;
+  entry->next = *slot;
+
+  if (entry->next) {
+    entry->next->previous = entry;
+  }
+
+  *slot = entry;
+}
+
+void kleins::timerWheel::unlink(timer* entry) {
+  if (entry->previous) {
+    entry->previous->next = entry->next;
+  } else {
+    *entry->slot = entry->next;
+  }
+
+  if (entry->next) {
+    entry->next->previous = entry->previous;
+  }
+
+  entry->next = 0;
+  entry->previous = 0;
+  entry->slot = 0;
+}
+
+void kleins::timerWheel::cascade(unsigned int level) {
+  timer** slot = &slots[level][(currentTick >> (slotBits * level)) & (slotCount - 1)];
+
+  while (*slot) {
+    timer* entry = *slot;
+
+    unlink(entry);
+    place(entry);
+  }
+}
+
+void kleins::timerWheel::schedule(timer* entry, uint64_t deadline) {
+  cancel(entry);
+
+  entry->deadline = deadline;
+  place(entry);
+
+  timerCount++;
+}
+
+void kleins::timerWheel::cancel(timer* entry) {
+  if (!entry->slot) {
+    return;
+  }
+
+  unlink(entry);
+  timerCount--;
+}
+
+size_t kleins::timerWheel::advance(uint64_t tick, const std::function<void(timer*)>& expired) {
+  size_t fired = 0;
+
+  while (currentTick < tick) {
+    if (timerCount == 0) {
+      currentTick = tick;
+      break;
+    }
+
+    currentTick++;
+
+    // Every time a level wraps around, the next slot of the level above is spread over it
+    for (unsigned int level = 1; level < levelCount; level++) {
+      if ((currentTick >> (slotBits * (level - 1))) & (slotCount - 1)) {
+        break;
+      }
+
+      cascade(level);
+    }
+
+    timer** slot = &slots[0][currentTick & (slotCount - 1)];
+
+    // Taken off one by one, the callback may cancel or schedule other timers
+    while (*slot) {
+      timer* entry = *slot;
+
+      unlink(entry);
+
+      if (entry->deadline > currentTick) {
+        place(entry);
+        continue;
+      }
+
+      timerCount--;
+      fired++;
+
+      expired(entry);
+    }
+  }
+
+  return fired;
+}
+
+uint64_t kleins::timerWheel::getCurrentTick() const {
+  return currentTick;
+}
+
+size_t kleins::timerWheel::size() const {
+  return timerCount;
+}
@@ -0,0 +1,89 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace kleins {
+
+/**
+ * @brief A hierarchical timer wheel, which schedules and cancels timers in constant time however many there are.
+ *
+ * Time is counted in ticks, what a tick stands for is up to the owner. Each level has 64 slots, a slot of the first level covers one tick
+ * and a slot of every further level covers all of the level below it. Timers sit on the lowest level their deadline fits into
+ * and move down a level whenever the level below wraps around, so advancing only ever touches the timers that are due
+ * and the few that move down. Deadlines further out than the last level are parked in it and moved along until they are in reach.
+ *
+ * The timers are part of the objects they belong to, so scheduling them doesn't allocate. The wheel isn't locked,
+ * it's meant to be owned by one thread or used under the lock of its owner.
+ */
+class timerWheel {
+public:
+  static const unsigned int slotBits = 6;
+  static const unsigned int slotCount = 1 << slotBits;
+  static const unsigned int levelCount = 4;
+
+  /**
+   * @brief A timer, embedded into whatever it times out. It must not be destroyed while it's scheduled.
+   */
+  struct timer {
+    uint64_t deadline = 0;
+
+    timer* next = 0;
+    timer* previous = 0;
+
+    // The slot the timer is in, 0 while it isn't scheduled
+    timer** slot = 0;
+
+    bool isScheduled() const;
+  };
+
+private:
+  timer* slots[levelCount][slotCount] = {};
+
+  uint64_t currentTick;
+  size_t timerCount = 0;
+
+  void place(timer* entry);
+  void unlink(timer* entry);
+  void cascade(unsigned int level);
+
+public:
+  /**
+   * @param startTick The tick the wheel starts at, timers due by then fire on the next advance
+   */
+  timerWheel(uint64_t startTick = 0);
+
+  timerWheel(const timerWheel&) = delete;
+  timerWheel& operator=(const timerWheel&) = delete;
+
+  /**
+   * @brief Schedule a timer to fire once the wheel advanced to deadline. A timer that is already scheduled is moved.
+   */
+  void schedule(timer* entry, uint64_t deadline);
+
+  /**
+   * @brief Take a timer off the wheel, nothing happens if it isn't scheduled
+   */
+  void cancel(timer* entry);
+
+  /**
+   * @brief Move the wheel forward and fire every timer due by then
+   *
+   * @param tick The tick to advance to, ticks before the current one are ignored
+   * @param expired Called with every timer that fired. It's no longer scheduled then, so the callback may schedule it again or destroy it.
+   * @return The amount of timers that fired
+   */
+  size_t advance(uint64_t tick, const std::function<void(timer*)>& expired);
+
+  uint64_t getCurrentTick() const;
+
+  /**
+   * @brief The amount of scheduled timers
+   */
+  size_t size() const;
+};
+}; // namespace kleins
+
+#endif
@@ -0,0 +1,104 @@
+#include "uringConnection.h"
+#include "../uringSocket/uringSocket.h"
+
+kleins::uringConnection::uringConnection(int connectionid, uringSocket* owner) {
+  connectionfd = connectionid;
+  socket = owner;
+  resetTimeoutTimer();
+}
+
+kleins::uringConnection::~uringConnection() {
+  close(connectionfd);
+}
+
+bool kleins::uringConnection::getAlive() {
+  return !closed;
+}
+
+int kleins::uringConnection::getFd() {
+  return connectionfd;
+}
+
+bool kleins::uringConnection::usesEventLoop() {
+  return false;
+}
+
+bool kleins::uringConnection::hasPendingOutput() {
+  return sending || !pendingOutput.empty();
+}
+
+void kleins::uringConnection::recieved(const char* data, int datalength) {
+  resetTimeoutTimer();
+
+  packet* packetBuffer = new packet;
+  packetBuffer->data.assign(data, datalength);
+  packetBuffer->size = datalength;
+
+  this->onRecieveCallback(std::unique_ptr<packet>(packetBuffer));
+}
+
+void kleins::uringConnection::tick() {
+  // Reads are delivered by the ring of the uringSocket, there is nothing to poll
+}
+
+void kleins::uringConnection::flush() {
+  if (!sending && !pendingOutput.empty()) {
+    socket->sendNext(this);
+  }
+}
+
+void kleins::uringConnection::writeData(const char* data, int datalength) {
+  if (closed || datalength <= 0) {
+    return;
+  }
+
+  if (pendingOutput.empty() || pendingOutput.back().filefd >= 0 || pendingOutput.back().shared) {
+    pendingOutput.emplace_back();
+  }
+
+  outputChunk& chunk = pendingOutput.back();
+  chunk.data.append(data, datalength);
+  chunk.length += datalength;
+
+  flush();
+}
+
+void kleins::uringConnection::writeShared(std::shared_ptr<const char> data, size_t length) {
+  if (closed || length == 0) {
+    return;
+  }
+
+  outputChunk chunk;
+  chunk.shared = std::move(data);
+  chunk.length = length;
+  pendingOutput.push_back(std::move(chunk));
+
+  flush();
+}
+
+void kleins::uringConnection::writeFile(int filefd, off_t offset, size_t length, std::shared_ptr<const void> fileOwner) {
+  if (closed || length == 0) {
+    return;
+  }
+
+  // The ring has no sendfile, the range is read through the ring in pieces as the sends complete
+  outputChunk chunk;
+  chunk.filefd = filefd;
+  chunk.offset = offset;
+  chunk.length = length;
+  chunk.fileOwner = std::move(fileOwner);
+  pendingOutput.push_back(std::move(chunk));
+
+  flush();
+}
+
+void kleins::uringConnection::close_socket() {
+  if (closed) {
+    return;
+  }
+
+  closed = true;
+
+  // Ends the multishot recv, the fd itself is closed once the ring is done with it
+  shutdown(connectionfd, SHUT_RDWR);
+}
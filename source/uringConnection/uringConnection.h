@@ -0,0 +1,64 @@
+#ifndef URINGCONNECTION_H
+#define URINGCONNECTION_H
+
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef SINGLE_HEADER
+#include "../connectionBase/connectionBase.h"
+#include "../packet/packet.h"
+#endif
+
+namespace kleins {
+class uringSocket;
+
+/**
+ * @brief A connection whose I/O is done through the io_uring of the uringSocket that accepted it.
+ *
+ * Reads arrive as completions on the socket's ring, writes are queued on it and go out with the next submission.
+ */
+class uringConnection : public connectionBase {
+  friend class uringSocket;
+
+private:
+  int connectionfd;
+  uringSocket* socket;
+
+  // Output waits in pendingOutput until the send in flight completed, one chunk is sent at a time.
+  // Bytes are sent from sendBuffer and shared memory from sendMemory, file ranges are read into sendBuffer piece by piece first.
+  // Whatever is sent has to stay put until the kernel is done with it.
+  std::string sendBuffer;
+  std::shared_ptr<const char> sendMemory;
+  const char* sendStart = 0;
+  size_t sendLength = 0;
+  size_t sendOffset = 0;
+
+  // Whether a send or a read of a file piece is in flight
+  bool sending = false;
+
+  // Operations on the ring that still reference this connection. It can only be deleted once this drops to 0.
+  unsigned int pendingOperations = 0;
+
+  void recieved(const char* data, int datalength);
+
+protected:
+  virtual void writeData(const char* data, int datalength);
+  virtual void writeFile(int filefd, off_t offset, size_t length, std::shared_ptr<const void> fileOwner);
+  virtual void writeShared(std::shared_ptr<const char> data, size_t length);
+
+public:
+  uringConnection(int connectionid, uringSocket* owner);
+  ~uringConnection();
+
+  virtual bool getAlive();
+  virtual int getFd();
+  virtual bool usesEventLoop();
+  virtual bool hasPendingOutput();
+  virtual void tick();
+  virtual void flush();
+  virtual void close_socket();
+};
+}; // namespace kleins
+
+#endif
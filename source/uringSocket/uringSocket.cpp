@@ -0,0 +1,431 @@
+#include "uringSocket.h"
+
+kleins::uringSocket::uringSocket(const char* listenAddress, const int listenPort, unsigned int queueDepthIn) {
+  address.sin_family = AF_INET;
+
+  address.sin_port = htons(listenPort);
+  inet_aton(listenAddress, (in_addr*)&address.sin_addr.s_addr);
+
+  queueDepth = queueDepthIn;
+  startTime = std::chrono::steady_clock::now();
+}
+
+kleins::uringSocket::~uringSocket() {
+  stopTicks();
+
+  for (auto conn : connections) {
+    delete conn;
+  }
+
+  if (recvBuffers != MAP_FAILED) {
+    munmap(recvBuffers, recvBufferCount * recvBufferSize);
+  }
+  if (sqes != MAP_FAILED) {
+    munmap(sqes, sqesSize);
+  }
+  if (cqRing != MAP_FAILED && cqRing != sqRing) {
+    munmap(cqRing, cqRingSize);
+  }
+  if (sqRing != MAP_FAILED) {
+    munmap(sqRing, sqRingSize);
+  }
+  if (ringfd >= 0) {
+    close(ringfd);
+  }
+
+  close(socketfd);
+}
+
+bool kleins::uringSocket::setupRing() {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  // Multishot operations post many completions per submission, so give the completion queue some headroom
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = queueDepth * 4;
+
+  ringfd = syscall(__NR_io_uring_setup, queueDepth, &params);
+  if (ringfd < 0) {
+    std::cerr << "Error creating io_uring" << std::endl;
+    return false;
+  }
+
+  sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+  }
+
+  sqRing = mmap(0, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQ_RING);
+  if (sqRing == MAP_FAILED) {
+    std::cerr << "Error mapping io_uring submission queue" << std::endl;
+    return false;
+  }
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cqRing = sqRing;
+  } else {
+    cqRing = mmap(0, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED) {
+      std::cerr << "Error mapping io_uring completion queue" << std::endl;
+      return false;
+    }
+  }
+
+  sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  sqes = (io_uring_sqe*)mmap(0, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    std::cerr << "Error mapping io_uring submission entries" << std::endl;
+    return false;
+  }
+
+  sqHead = (unsigned*)((char*)sqRing + params.sq_off.head);
+  sqTail = (unsigned*)((char*)sqRing + params.sq_off.tail);
+  sqMask = (unsigned*)((char*)sqRing + params.sq_off.ring_mask);
+  sqArray = (unsigned*)((char*)sqRing + params.sq_off.array);
+
+  cqHead = (unsigned*)((char*)cqRing + params.cq_off.head);
+  cqTail = (unsigned*)((char*)cqRing + params.cq_off.tail);
+  cqMask = (unsigned*)((char*)cqRing + params.cq_off.ring_mask);
+  cqes = (io_uring_cqe*)((char*)cqRing + params.cq_off.cqes);
+
+  recvBuffers = (char*)mmap(0, recvBufferCount * recvBufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (recvBuffers == MAP_FAILED) {
+    std::cerr << "Error allocating io_uring recv buffers" << std::endl;
+    return false;
+  }
+
+  // Hand all recv buffers to the kernel at once, they go out with the first submission
+  io_uring_sqe* sqe = nextSqe(URING_OP_PROVIDE);
+  sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+  sqe->fd = recvBufferCount;
+  sqe->addr = (uint64_t)recvBuffers;
+  sqe->len = recvBufferSize;
+  sqe->off = 0;
+  sqe->buf_group = recvBufferGroup;
+
+  return true;
+}
+
+int kleins::uringSocket::enter(unsigned int toSubmit, unsigned int minComplete, unsigned int flags) {
+  int submitted = syscall(__NR_io_uring_enter, ringfd, toSubmit, minComplete, flags, NULL, 0);
+
+  if (submitted > 0) {
+    unsubmitted -= submitted;
+  }
+
+  return submitted;
+}
+
+io_uring_sqe* kleins::uringSocket::nextSqe(uint64_t userData) {
+  unsigned int tail = *sqTail;
+
+  // Only submit early if the queue is full, everything else goes out with the next tick
+  if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) > *sqMask) {
+    enter(unsubmitted, 0, 0);
+  }
+
+  unsigned int index = tail & *sqMask;
+  io_uring_sqe* sqe = &sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->user_data = userData;
+
+  sqArray[index] = index;
+  __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+  unsubmitted++;
+
+  return sqe;
+}
+
+void kleins::uringSocket::returnRecvBuffer(unsigned short bufferId) {
+  io_uring_sqe* sqe = nextSqe(URING_OP_PROVIDE);
+  sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+  sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+  sqe->fd = 1;
+  sqe->addr = (uint64_t)(recvBuffers + bufferId * recvBufferSize);
+  sqe->len = recvBufferSize;
+  sqe->off = bufferId;
+  sqe->buf_group = recvBufferGroup;
+}
+
+void kleins::uringSocket::queueAccept() {
+  io_uring_sqe* sqe = nextSqe(URING_OP_ACCEPT);
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = socketfd;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->accept_flags = SOCK_CLOEXEC;
+}
+
+void kleins::uringSocket::queueRecv(uringConnection* conn) {
+  io_uring_sqe* sqe = nextSqe((uint64_t)conn | URING_OP_RECV);
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = conn->connectionfd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = recvBufferGroup;
+
+  conn->pendingOperations++;
+}
+
+void kleins::uringSocket::queueSend(uringConnection* conn) {
+  io_uring_sqe* sqe = nextSqe((uint64_t)conn | URING_OP_SEND);
+  sqe->opcode = IORING_OP_SEND;
+  sqe->fd = conn->connectionfd;
+  sqe->addr = (uint64_t)(conn->sendStart + conn->sendOffset);
+  sqe->len = conn->sendLength - conn->sendOffset;
+  sqe->msg_flags = MSG_NOSIGNAL;
+
+  conn->pendingOperations++;
+}
+
+void kleins::uringSocket::queueRead(uringConnection* conn, int filefd, off_t offset, size_t length) {
+  io_uring_sqe* sqe = nextSqe((uint64_t)conn | URING_OP_READ);
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = filefd;
+  sqe->addr = (uint64_t)conn->sendBuffer.data();
+  sqe->len = length;
+  sqe->off = offset;
+
+  conn->pendingOperations++;
+}
+
+void kleins::uringSocket::sendNext(uringConnection* conn) {
+  connectionBase::outputChunk& chunk = conn->pendingOutput.front();
+  conn->sending = true;
+
+  // The chunk stays queued until the read completed, it's advanced by what was actually read
+  if (chunk.filefd >= 0) {
+    size_t length = std::min(chunk.length, fileReadSize);
+    conn->sendBuffer.resize(length);
+
+    queueRead(conn, chunk.filefd, chunk.offset, length);
+    return;
+  }
+
+  if (chunk.shared) {
+    conn->sendMemory = std::move(chunk.shared);
+    conn->sendStart = conn->sendMemory.get() + chunk.offset;
+  } else {
+    conn->sendBuffer.swap(chunk.data);
+    conn->sendStart = conn->sendBuffer.data() + chunk.offset;
+  }
+
+  conn->sendLength = chunk.length;
+  conn->sendOffset = 0;
+  conn->pendingOutput.pop_front();
+
+  queueSend(conn);
+}
+
+void kleins::uringSocket::queueSweep() {
+  io_uring_sqe* sqe = nextSqe(URING_OP_SWEEP);
+  sqe->opcode = IORING_OP_TIMEOUT;
+  sqe->addr = (uint64_t)&sweepInterval;
+  sqe->len = 1;
+}
+
+void kleins::uringSocket::interruptTicks() {
+  // Ends the multishot accept, otherwise the sweep wakes the ring up within a second
+  shutdown(socketfd, SHUT_RDWR);
+}
+
+bool kleins::uringSocket::tick(unsigned int /*shard*/) {
+  // Submits everything queued since the last tick and waits for at least one completion in the same syscall
+  if (enter(unsubmitted, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EBUSY) {
+    std::cerr << "Error waiting on io_uring" << std::endl;
+    return false;
+  }
+
+  now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+  unsigned int head = *cqHead;
+  while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+    io_uring_cqe cqe = cqes[head & *cqMask];
+    __atomic_store_n(cqHead, ++head, __ATOMIC_RELEASE);
+
+    handleCompletion(&cqe);
+  }
+
+  closeTimedOut();
+
+  return true;
+}
+
+void kleins::uringSocket::handleCompletion(io_uring_cqe* cqe) {
+  uringConnection* conn = (uringConnection*)(cqe->user_data & ~(uint64_t)7);
+
+  switch (cqe->user_data & 7) {
+  case URING_OP_ACCEPT:
+    onAccept(cqe);
+    break;
+
+  case URING_OP_RECV:
+    onRecv(conn, cqe);
+    releaseIfDone(conn);
+    break;
+
+  case URING_OP_SEND:
+    onSend(conn, cqe);
+    releaseIfDone(conn);
+    break;
+
+  case URING_OP_READ:
+    onRead(conn, cqe);
+    releaseIfDone(conn);
+    break;
+
+  case URING_OP_SWEEP:
+    onSweep();
+    break;
+
+  case URING_OP_PROVIDE:
+    // Only failures post a completion, and there is nothing to do about them
+    break;
+
+  default:
+    break;
+  }
+}
+
+void kleins::uringSocket::onAccept(io_uring_cqe* cqe) {
+  if (cqe->res >= 0) {
+    uringConnection* conn = new uringConnection(cqe->res, this);
+    connections.insert(conn);
+
+    newConnectionCallback(conn);
+    conn->startTimeouts(&timeouts, &now);
+    queueRecv(conn);
+  }
+
+  if (!(cqe->flags & IORING_CQE_F_MORE)) {
+    queueAccept();
+  }
+}
+
+void kleins::uringSocket::onRecv(uringConnection* conn, io_uring_cqe* cqe) {
+  if (cqe->res > 0) {
+    unsigned short bufferId = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+    if (!conn->closed) {
+      conn->recieved(recvBuffers + bufferId * recvBufferSize, cqe->res);
+    }
+
+    returnRecvBuffer(bufferId);
+  } else if (cqe->res == 0) {
+    conn->closeAfterFlush();
+  } else if (cqe->res != -ENOBUFS) {
+    conn->close_socket();
+  }
+
+  if (!(cqe->flags & IORING_CQE_F_MORE)) {
+    conn->pendingOperations--;
+
+    if (!conn->closed && !conn->closeRequested) {
+      queueRecv(conn);
+    }
+  }
+}
+
+void kleins::uringSocket::onSend(uringConnection* conn, io_uring_cqe* cqe) {
+  conn->pendingOperations--;
+
+  if (cqe->res < 0) {
+    conn->sending = false;
+    conn->sendMemory.reset();
+    conn->close_socket();
+    return;
+  }
+
+  conn->sendOffset += cqe->res;
+  conn->resetTimeoutTimer();
+
+  if (conn->sendOffset < conn->sendLength && !conn->closed) {
+    queueSend(conn);
+    return;
+  }
+
+  conn->sending = false;
+  conn->sendMemory.reset();
+
+  if (!conn->pendingOutput.empty() && !conn->closed) {
+    sendNext(conn);
+  } else if (conn->closeRequested) {
+    conn->close_socket();
+  }
+}
+
+void kleins::uringSocket::onRead(uringConnection* conn, io_uring_cqe* cqe) {
+  conn->pendingOperations--;
+
+  if (conn->closed) {
+    conn->sending = false;
+    return;
+  }
+
+  if (cqe->res <= 0) {
+    conn->sending = false;
+    conn->close_socket();
+    return;
+  }
+
+  connectionBase::outputChunk& chunk = conn->pendingOutput.front();
+  chunk.offset += cqe->res;
+  chunk.length -= cqe->res;
+
+  if (chunk.length == 0) {
+    conn->pendingOutput.pop_front();
+  }
+
+  conn->sendStart = conn->sendBuffer.data();
+  conn->sendLength = cqe->res;
+  conn->sendOffset = 0;
+
+  queueSend(conn);
+}
+
+void kleins::uringSocket::onSweep() {
+  // The timeouts are checked after every batch, the sweep only wakes the ring up for that
+  queueSweep();
+}
+
+void kleins::uringSocket::closeTimedOut() {
+  timeouts.advance(now, [this](timerWheel::timer* fired) {
+    uringConnection* conn = static_cast<uringConnection*>(static_cast<connectionTimer*>(fired)->owner);
+
+    if (!conn->closed && conn->timeoutFired()) {
+      conn->close_socket();
+      releaseIfDone(conn);
+    }
+  });
+}
+
+void kleins::uringSocket::releaseIfDone(uringConnection* conn) {
+  if (!conn->closed || conn->pendingOperations != 0) {
+    return;
+  }
+
+  connections.erase(conn);
+  delete conn;
+}
+
+std::future<bool> kleins::uringSocket::init() {
+  auto init_async = [this]() {
+    socketfd = openListenSocket(address);
+
+    if (socketfd < 0) {
+      return false;
+    }
+
+    if (!setupRing()) {
+      return false;
+    }
+
+    queueAccept();
+    queueSweep();
+
+    return true;
+  };
+
+  return std::async(std::launch::async, init_async);
+}
@@ -0,0 +1,133 @@
+#ifndef URINGSOCKET_H
+#define URINGSOCKET_H
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifndef SINGLE_HEADER
+#include "../socketBase/socketBase.h"
+#include "../timerWheel/timerWheel.h"
+#include "../uringConnection/uringConnection.h"
+#endif
+
+namespace kleins {
+
+/**
+ * @brief A tcp socket that does accept, recv and send for all of its connections through one io_uring.
+ *
+ * Accepts and reads are multishot, reads land in a pool of buffers provided to the kernel up front,
+ * and everything queued while handling a batch of completions goes out with a single io_uring_enter.
+ * Can be used in place of a tcpSocket with httpServer::addSocket.
+ */
+class uringSocket : public socketBase {
+  friend class uringConnection;
+
+private:
+  // Stored in the low bits of the user data of every submission, next to the connection pointer
+  enum uringOperation {
+    URING_OP_ACCEPT = 1,
+    URING_OP_RECV = 2,
+    URING_OP_SEND = 3,
+    URING_OP_SWEEP = 4,
+    URING_OP_PROVIDE = 5,
+    URING_OP_READ = 6,
+  };
+
+  // File ranges are read and sent in pieces of this size, so a large file never sits in memory as a whole
+  static constexpr size_t fileReadSize = 256 * 1024;
+
+  int socketfd = -1;
+  struct sockaddr_in address;
+
+  unsigned int queueDepth;
+  int ringfd = -1;
+
+  // Submission queue, shared with the kernel
+  void* sqRing = MAP_FAILED;
+  size_t sqRingSize;
+  unsigned* sqHead;
+  unsigned* sqTail;
+  unsigned* sqMask;
+  unsigned* sqArray;
+  io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+  size_t sqesSize;
+  unsigned int unsubmitted = 0;
+
+  // Completion queue, shared with the kernel
+  void* cqRing = MAP_FAILED;
+  size_t cqRingSize;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned* cqMask;
+  io_uring_cqe* cqes;
+
+  // Buffers provided to the kernel that multishot recvs pick from, a buffer is handed back once its data was delivered
+  static const unsigned int recvBufferCount = 1024;
+  static const unsigned int recvBufferSize = 4096;
+  static const unsigned short recvBufferGroup = 0;
+  char* recvBuffers = (char*)MAP_FAILED;
+
+  // Completes once a second, so the timeouts are checked even when nothing else happens
+  struct __kernel_timespec sweepInterval = {1, 0};
+
+  // The timeouts of all connections, in milliseconds since the ring was set up. now is read once per batch of completions.
+  std::chrono::time_point<std::chrono::steady_clock> startTime;
+  uint64_t now = 0;
+  timerWheel timeouts;
+
+  std::unordered_set<uringConnection*> connections;
+
+  io_uring_sqe* nextSqe(uint64_t userData);
+  int enter(unsigned int toSubmit, unsigned int minComplete, unsigned int flags);
+
+  void queueAccept();
+  void queueRecv(uringConnection* conn);
+  void queueSend(uringConnection* conn);
+  void queueRead(uringConnection* conn, int filefd, off_t offset, size_t length);
+  void sendNext(uringConnection* conn);
+  void queueSweep();
+  void returnRecvBuffer(unsigned short bufferId);
+
+  void handleCompletion(io_uring_cqe* cqe);
+  void onAccept(io_uring_cqe* cqe);
+  void onRecv(uringConnection* conn, io_uring_cqe* cqe);
+  void onSend(uringConnection* conn, io_uring_cqe* cqe);
+  void onRead(uringConnection* conn, io_uring_cqe* cqe);
+  void onSweep();
+  void closeTimedOut();
+  void releaseIfDone(uringConnection* conn);
+
+  bool setupRing();
+
+  bool tick(unsigned int shard);
+  void interruptTicks();
+
+public:
+  /**
+   * @brief Construct a new io_uring socket
+   *
+   * @param listenAddress The address to listen on
+   * @param listenPort The port to listen on
+   * @param queueDepth The amount of submission queue entries of the ring
+   */
+  uringSocket(const char* listenAddress, const int listenPort, unsigned int queueDepth = 4096);
+  ~uringSocket();
+
+  std::future<bool> init();
+};
+
+}; // namespace kleins
+
+#endif
@@ -0,0 +1,83 @@
+#include "workerPool.h"
+
+kleins::workerPool::workerPool(unsigned int threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (unsigned int i = 0; i < threadCount; i++) {
+    queues.push_back(std::unique_ptr<taskQueue>(new taskQueue));
+  }
+
+  for (unsigned int i = 0; i < threadCount; i++) {
+    threads.push_back(new std::thread(workerLoop, this, i));
+  }
+}
+
+kleins::workerPool::~workerPool() {
+  {
+    std::lock_guard<std::mutex> lock(idleMutex);
+    keepRunning = false;
+  }
+  idleCondition.notify_all();
+
+  for (auto thread : threads) {
+    thread->join();
+    delete thread;
+  }
+}
+
+void kleins::workerPool::submit(std::function<void()> task) {
+  taskQueue* queue = queues[nextQueue++ % queues.size()].get();
+
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(idleMutex);
+    queuedTasks++;
+  }
+  idleCondition.notify_one();
+}
+
+bool kleins::workerPool::takeTask(unsigned int index, std::function<void()>& task) {
+  for (unsigned int i = 0; i < queues.size(); i++) {
+    taskQueue* queue = queues[(index + i) % queues.size()].get();
+
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->tasks.empty()) {
+      continue;
+    }
+
+    // The own queue is worked from the front, the others are stolen from at the back
+    if (i == 0) {
+      task = std::move(queue->tasks.front());
+      queue->tasks.pop_front();
+    } else {
+      task = std::move(queue->tasks.back());
+      queue->tasks.pop_back();
+    }
+
+    queuedTasks--;
+    return true;
+  }
+
+  return false;
+}
+
+void kleins::workerPool::workerLoop(workerPool* pool, unsigned int index) {
+  std::function<void()> task;
+
+  while (pool->keepRunning) {
+    if (pool->takeTask(index, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(pool->idleMutex);
+    pool->idleCondition.wait(lock, [pool]() { return pool->queuedTasks > 0 || !pool->keepRunning; });
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kleins {
+
+/**
+ * @brief A fixed set of threads that run submitted tasks.
+ *
+ * Every thread has its own queue and takes work from its front. Threads that run dry steal from the back of the others,
+ * so a few slow tasks don't hold up the ones queued behind them while other threads idle.
+ */
+class workerPool {
+private:
+  struct taskQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<taskQueue>> queues;
+  std::vector<std::thread*> threads;
+
+  std::atomic<unsigned int> nextQueue{0};
+  std::atomic<size_t> queuedTasks{0};
+  std::atomic<bool> keepRunning{true};
+
+  // Idle threads sleep here until something gets submitted
+  std::mutex idleMutex;
+  std::condition_variable idleCondition;
+
+  static void workerLoop(workerPool* pool, unsigned int index);
+  bool takeTask(unsigned int index, std::function<void()>& task);
+
+public:
+  /**
+   * @brief Start the pool
+   *
+   * @param threadCount The amount of threads. 0 uses one per core.
+   */
+  workerPool(unsigned int threadCount = 0);
+
+  /**
+   * @brief Finish the running tasks and stop all threads. Tasks that haven't started yet are dropped.
+   */
+  ~workerPool();
+
+  /**
+   * @brief Queue a task to be run on one of the pool threads
+   */
+  void submit(std::function<void()> task);
+};
+
+} // namespace kleins
+
+#endif